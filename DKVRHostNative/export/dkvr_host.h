@@ -6,7 +6,7 @@
 #	define DLLEXPORT	__declspec( dllimport )
 #endif
 
-#define DKVR_HOST_EXPORTED_HEADER_VER	1003
+#define DKVR_HOST_EXPORTED_HEADER_VER	1004
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,15 +38,108 @@ extern "C" {
     struct DKVRVector3 { float x, y, z; };
     struct DKVRQuaternion { float w, x, y, z; };
     struct DKVRCalibration { float gyr_transform[12], acc_transform[12], mag_transform[12], noise_variance[9]; };
+    struct DKVRTrackerSnapshot
+    {
+        unsigned long address;
+        int connection_status;
+        struct DKVRQuaternion orientation;
+        struct DKVRVector3 linear_acceleration;
+        struct DKVRVector3 magnetic_disturbance;
+        struct DKVRVector3 raw_gyro;
+        struct DKVRVector3 raw_accel;
+        struct DKVRVector3 raw_mag;
+        long long timestamp;    // host receive time of the latest data, steady clock in nanoseconds
+    };
+
+    enum DKVRSampleKind
+    {
+        Raw,
+        Nominal
+    };
+    struct DKVRRawData { struct DKVRVector3 gyr, acc, mag; };
+    struct DKVRNominalData { struct DKVRQuaternion orientation; struct DKVRVector3 linear_acceleration, magnetic_disturbance; };
+    struct DKVRTimedSample
+    {
+        long long timestamp;        // host receive time, steady clock in nanoseconds
+        unsigned int sequence;      // device sequence number
+        int kind;                   // DKVRSampleKind, selects the member of data
+        union
+        {
+            struct DKVRRawData raw;
+            struct DKVRNominalData nominal;
+        } data;
+    };
+
+    struct DKVRConfigSyncStat
+    {
+        unsigned long long synced;              // configuration keys acknowledged by the tracker
+        unsigned long long transmissions;       // configuration packets sent, including retransmissions
+        unsigned long long retransmissions;
+        unsigned int last_latency;              // milliseconds from first transmission to acknowledgement
+        unsigned int max_latency;
+    };
+
+    // stages of the receive pipeline, each one measured from the end of the previous stage
+    enum DKVRLatencyStage
+    {
+        KernelToReceive,        // kernel receive timestamp to network thread (Linux only)
+        ReceiveToQueue,         // network thread to receiving queue
+        QueueToPop,             // receiving queue to dispatcher worker
+        PopToDispatch,
+        DispatchToLock,         // tracker lookup and lock
+        LockToPublish,          // instruction handling under the tracker lock
+        KernelToPublish,        // whole pipeline, only instructions which published samples
+        LatencyStageCount
+    };
+    struct DKVRLatencyHistogram
+    {
+        unsigned long long count;
+        long long min, max, mean;           // nanoseconds
+        long long p50, p90, p99, p999;      // upper bound of the bucket, within 12.5% of the actual value
+    };
+
+    struct DKVRTrackerNetworkCounters
+    {
+        unsigned long long rx_packets, rx_bytes;    // datagrams handed to the tracker, late ones included
+        unsigned long long tx_packets, tx_bytes;    // instructions placed to the sending queue
+        unsigned long long late_discards;           // sequence number older than the latest one handled
+        unsigned long long sequence_gaps;           // datagrams inferred lost from jumps of the sequence number
+    };
+    struct DKVRNetworkCounters
+    {
+        unsigned long long rx_packets, rx_bytes;    // every datagram received by the socket, invalid ones included
+        unsigned long long tx_packets, tx_bytes;    // every datagram accepted by the socket
+        unsigned long long send_errors;             // rejected by the socket and dropped
+        unsigned long long received_dropped;        // receiving queue overflow, oldest datagram replaced
+        unsigned long long sending_dropped;         // sending queue overflow
+        unsigned long long invalid_truncated;       // dropped at receive time, shorter than the header
+        unsigned long long invalid_opener;
+        unsigned long long invalid_length;          // length field beyond the bytes received, or datagram larger than an instruction
+        unsigned long long invalid_opcode;
+    };
+    struct DKVRBatchStatistic
+    {
+        int batch_size;                                 // datagrams one syscall can handle, 0 if the server has no batching
+        unsigned long long recv_calls, recv_datagrams;  // calls which handled at least one datagram
+        unsigned long long recv_full;                   // calls which filled the whole batch
+        unsigned long long send_calls, send_datagrams;
+        unsigned long long send_full;
+    };
 
     typedef void* DKVRHostHandle;
+    typedef void (__stdcall *DKVRSampleCallback)(void* context, int index, const struct DKVRTimedSample* sample);
 
     // version
     DLLEXPORT void __stdcall dkvrGetVersion(int* out);
     DLLEXPORT void __stdcall dkvrAssertVersion(int version, int* success);
 
+    // host steady clock in nanoseconds, time base of every timestamp in this header
+    DLLEXPORT void __stdcall dkvrGetHostTimestamp(long long* out);
+
     // instance control
     DLLEXPORT void __stdcall dkvrCreateInstance	(DKVRHostHandle* hptr, char* msg, int len);
+    // dispatcher_workers threads handle received instructions, trackers are distributed among them by address (1 to 16)
+    DLLEXPORT void __stdcall dkvrCreateInstanceWithWorkers(DKVRHostHandle* hptr, int dispatcher_workers, char* msg, int len);
     DLLEXPORT void __stdcall dkvrDeleteInstance	(DKVRHostHandle* hptr);
     DLLEXPORT void __stdcall dkvrRunHost		(DKVRHostHandle handle, DKVRAddress address);
     DLLEXPORT void __stdcall dkvrStopHost		(DKVRHostHandle handle);
@@ -61,6 +154,8 @@ extern "C" {
     DLLEXPORT void __stdcall dkvrLoggerGetUncheckCount		(DKVRHostHandle handle, int* out);
     DLLEXPORT void __stdcall dkvrLoggerGetUncheckedLogOne	(DKVRHostHandle handle, char* out, int len);
     DLLEXPORT void __stdcall dkvrLoggerGetUncheckedLogAll	(DKVRHostHandle handle, char* out, int len);
+    DLLEXPORT void __stdcall dkvrLoggerSetUncheckedCapacity	(DKVRHostHandle handle, int bytes);
+    DLLEXPORT void __stdcall dkvrLoggerGetDroppedCount		(DKVRHostHandle handle, unsigned long long* out);
 
 	DLLEXPORT void __stdcall dkvrLoggerSetLevelDebug(DKVRHostHandle handle);
 	DLLEXPORT void __stdcall dkvrLoggerSetLevelInfo(DKVRHostHandle handle);
@@ -98,10 +193,51 @@ extern "C" {
     DLLEXPORT void __stdcall dkvrTrackerGetLinearAcceleration(DKVRHostHandle handle, int index, struct DKVRVector3* out);
     DLLEXPORT void __stdcall dkvrTrackerGetMagneticDisturbance(DKVRHostHandle handle, int index, struct DKVRVector3* out);
 
+    // fill out[0..capacity) in one call without locking, count receives the number of entries written
+    DLLEXPORT void __stdcall dkvrTrackerGetSnapshotAll		(DKVRHostHandle handle, struct DKVRTrackerSnapshot* out, int capacity, int* count);
+
+    // orientation at timestamp (dkvrGetHostTimestamp time base), slerp between the latest two nominal samples
+    // or extrapolated with their angular velocity, prediction horizon is clamped to 50ms after the latest sample
+    DLLEXPORT void __stdcall dkvrTrackerPredictOrientation	(DKVRHostHandle handle, int index, long long timestamp, struct DKVRQuaternion* out);
+    DLLEXPORT void __stdcall dkvrTrackerPredictOrientationAll(DKVRHostHandle handle, long long timestamp, struct DKVRQuaternion* out, int capacity, int* count);
+
+    // sample history, every consumer keeps its own cursor
+    // GetSampleCursor gives the cursor skipping every sample received so far, cursor 0 begins with the oldest sample kept
+    // ReadSamples advances cursor, lost receives the number of samples overwritten before being read
+    DLLEXPORT void __stdcall dkvrTrackerGetSampleCursor		(DKVRHostHandle handle, int index, unsigned long long* cursor);
+    DLLEXPORT void __stdcall dkvrTrackerReadSamples			(DKVRHostHandle handle, int index, unsigned long long* cursor, struct DKVRTimedSample* out, int capacity, int* count, unsigned long long* lost);
+
     DLLEXPORT void __stdcall dkvrTrackerRequestLocate       (DKVRHostHandle handle, int index);
     DLLEXPORT void __stdcall dkvrTrackerRequestStatus       (DKVRHostHandle handle, int index);
     DLLEXPORT void __stdcall dkvrTrackerRequestStatistic	(DKVRHostHandle handle, int index);
 
+    // configuration is retransmitted with exponential backoff until the tracker acknowledges it
+    DLLEXPORT void __stdcall dkvrTrackerGetConfigSyncStat	(DKVRHostHandle handle, int index, struct DKVRConfigSyncStat* out);
+
+    // latency histograms of the receive pipeline, merged over every thread since the last reset
+    DLLEXPORT void __stdcall dkvrStatsGetLatencyHistogram	(DKVRHostHandle handle, int stage, struct DKVRLatencyHistogram* out);
+    // non-empty buckets in ascending order, bounds receives the highest nanoseconds counted by each bucket
+    DLLEXPORT void __stdcall dkvrStatsGetLatencyBuckets		(DKVRHostHandle handle, int stage, unsigned long long* counts, long long* bounds, int capacity, int* count);
+    DLLEXPORT void __stdcall dkvrStatsResetLatencyHistogram	(DKVRHostHandle handle);
+
+    // cumulative network counters since the instance was created, read without locking
+    // GetTrackerNetworkCountersAll fills out[0..capacity) by tracker index, count receives the number of entries written
+    DLLEXPORT void __stdcall dkvrStatsGetNetworkCounters	(DKVRHostHandle handle, struct DKVRNetworkCounters* out);
+    DLLEXPORT void __stdcall dkvrStatsGetTrackerNetworkCountersAll(DKVRHostHandle handle, struct DKVRTrackerNetworkCounters* out, int capacity, int* count);
+    // recvmmsg/sendmmsg batch fill, for tuning DKVR_EPOLL_BATCH_SIZE
+    // GetBatchFill fills fill[n] with the calls which handled exactly n datagrams, n from 0 to batch_size, send selects the direction
+    DLLEXPORT void __stdcall dkvrStatsGetBatchStatistic		(DKVRHostHandle handle, struct DKVRBatchStatistic* out);
+    DLLEXPORT void __stdcall dkvrStatsGetBatchFill			(DKVRHostHandle handle, int send, unsigned long long* fill, int capacity, int* count);
+
+    // event tracing of host threads, off by default
+    // each thread keeps its latest 16384 events, Dump writes the events since the last Start as Chrome trace JSON
+    // (open with chrome://tracing or ui.perfetto.dev), it may be called while tracing
+    // up to 64 threads are traced at once, the slot of an exited thread is reused and otherData.untraced_threads counts the threads left out
+    DLLEXPORT void __stdcall dkvrTraceStart                 (DKVRHostHandle handle);
+    DLLEXPORT void __stdcall dkvrTraceStop                  (DKVRHostHandle handle);
+    DLLEXPORT void __stdcall dkvrTraceIsRunning             (DKVRHostHandle handle, int* running);
+    DLLEXPORT void __stdcall dkvrTraceDump                  (DKVRHostHandle handle, const char* path, int* success);
+
     // calibrator
     DLLEXPORT void __stdcall dkvrCalibratorGetStatus        (DKVRHostHandle handle, int* out);
     DLLEXPORT void __stdcall dkvrCalibratorGetSampleType    (DKVRHostHandle handle, int* out);
@@ -113,6 +249,19 @@ extern "C" {
     DLLEXPORT void __stdcall dkvrCalibratorAbort            (DKVRHostHandle handle);
     DLLEXPORT void __stdcall dkvrCalibratorContinue         (DKVRHostHandle handle);
 
+    // sample notification
+    // callback is invoked on a dispatcher thread for every raw/nominal sample, one call at a time, pass null to unregister
+    // it must return quickly, and must not register another callback from inside
+    DLLEXPORT void __stdcall dkvrRegisterSampleCallback     (DKVRHostHandle handle, DKVRSampleCallback callback, void* context);
+    // bit n of mask selects tracker index n (index above 63 shares bit 63), arrived is 0 on timeout
+    DLLEXPORT void __stdcall dkvrWaitForSamples             (DKVRHostHandle handle, int timeout_ms, unsigned long long mask, int* arrived);
+
+    // pose publisher, layout of the shared memory is defined in dkvr_pose_shm.h
+    // name can be null to use DKVR_POSE_SHM_DEFAULT_NAME
+    DLLEXPORT void __stdcall dkvrPosePublisherRun           (DKVRHostHandle handle, const char* name, int* success);
+    DLLEXPORT void __stdcall dkvrPosePublisherStop          (DKVRHostHandle handle);
+    DLLEXPORT void __stdcall dkvrPosePublisherIsRunning     (DKVRHostHandle handle, int* running);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+// Shared memory pose channel layout, written by the host and read by any number of processes.
+// Segment : DKVRPoseShmHeader followed by slot_capacity DKVRPoseSlot.
+//
+// reader protocol (per slot)
+//   1. s0 = sequence (acquire), retry if odd
+//   2. copy the slot
+//   3. s1 = sequence (acquire fence before load), retry if s0 != s1
+//
+// frame_counter increases by one after every publish pass which updated at least one slot.
+
+#define DKVR_POSE_SHM_MAGIC             0x4B50564Bu     // "KVPK"
+#define DKVR_POSE_SHM_LAYOUT_VER        1
+#define DKVR_POSE_SHM_DEFAULT_NAME      "/dkvr_pose"
+#define DKVR_POSE_SHM_SLOT_CAPACITY     256             // one slot for every tracker the host can hold
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    struct DKVRPoseShmHeader
+    {
+        uint32_t magic;
+        uint32_t layout_version;
+        uint32_t header_size;       // offset of the first slot
+        uint32_t slot_size;
+        uint32_t slot_capacity;
+        uint32_t tracker_count;     // number of slots in use
+        uint64_t frame_counter;
+        uint32_t reserved[8];
+    };
+
+    struct DKVRPoseSlot
+    {
+        uint32_t sequence;          // odd while the host is writing
+        uint32_t connection_status;
+        uint32_t address;           // IPv4 address in network byte order
+        uint32_t reserved;
+        int64_t  timestamp;         // host receive time, steady clock in nanoseconds
+        float orientation[4];       // w, x, y, z
+        float linear_acceleration[3];
+        float magnetic_disturbance[3];
+        float raw_gyro[3];
+        float raw_accel[3];
+        float raw_mag[3];
+        uint32_t padding[7];
+    };
+
+#ifdef __cplusplus
+}
+
+static_assert(sizeof(DKVRPoseShmHeader) == 64);
+static_assert(sizeof(DKVRPoseSlot) == 128);
+#endif
\ No newline at end of file
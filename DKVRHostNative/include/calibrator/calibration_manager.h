@@ -18,6 +18,7 @@
 #include "tracker/tracker_data.h"
 #include "tracker/tracker_provider.h"
 
+#include "util/event_tracer.h"
 #include "util/logger.h"
 
 namespace dkvr
@@ -83,6 +84,7 @@ namespace dkvr
 
 		TrackerProvider& tk_provider_;
 		Logger& logger_ = Logger::GetInstance();
+		EventTracer& tracer_ = EventTracer::GetInstance();
 	};
 
 }	// namespace dkvr
\ No newline at end of file
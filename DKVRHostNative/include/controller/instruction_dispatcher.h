@@ -1,32 +1,71 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "controller/instruction_handler.h"
+#include "controller/sample_notifier.h"
+#include "controller/tracker_updater.h"
 #include "instruction/instruction_format.h"
 #include "network/network_service.h"
 #include "tracker/tracker_provider.h"
+#include "util/event_tracer.h"
 #include "util/logger.h"
+#include "util/pipeline_latency.h"
 #include "util/thread_container.h"
 
 namespace dkvr {
 
+	/// <summary>
+	/// <para>Handles received instructions with one worker per receive shard of the network service.</para>
+	/// <para>A tracker always belongs to the same shard, so instructions of a tracker are handled in order
+	/// while different trackers are handled in parallel.</para>
+	/// </summary>
 	class InstructionDispatcher
 	{
 	public:
-		InstructionDispatcher(NetworkService& net_service, TrackerProvider& tk_provider);
+		InstructionDispatcher(NetworkService& net_service, TrackerProvider& tk_provider, SampleNotifier& notifier, TrackerUpdater& updater, PipelineLatency& latency);
 
 		void Run();
 		void Stop();
 
+		size_t worker_count() const { return workers_.size(); }
+
 	private:
-		void WaitReceiveAndDispatch();
-		void Dispatch(unsigned long address, Instruction& inst);
+		class Worker
+		{
+		public:
+			Worker(InstructionDispatcher& owner, size_t shard) : owner_(owner), shard_(shard), thread_(*this, "dispatcher " + std::to_string(shard)) { thread_ += &Worker::WaitReceiveAndDispatch; }
+
+			ThreadContainer<Worker>& thread() { return thread_; }
+
+		private:
+			void WaitReceiveAndDispatch() { owner_.WaitReceiveAndDispatch(shard_); }
+
+			InstructionDispatcher& owner_;
+			const size_t shard_;
+			ThreadContainer<Worker> thread_;
+		};
+
+		void WaitReceiveAndDispatch(size_t shard);
+		void Dispatch(size_t shard, unsigned long address, Instruction& inst, const DatagramTimestamp& timestamp);
 
 		InstructionHandler inst_handler_;
-		ThreadContainer<InstructionDispatcher> dispatcher_thread_;
+		std::vector<std::unique_ptr<Worker>> workers_;
 
 		NetworkService& net_service_;
 		TrackerProvider& tk_provider_;
+		SampleNotifier& notifier_;
+		TrackerUpdater& updater_;
 		Logger& logger_ = Logger::GetInstance();
+		PipelineLatency& latency_;
+		EventTracer& tracer_ = EventTracer::GetInstance();
+
+		// per-packet error paths, limited per tracker address
+		LogRateLimiter late_log_limit_;
 	};
 
 }	// namespace dkvr
\ No newline at end of file
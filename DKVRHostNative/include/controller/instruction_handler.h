@@ -1,9 +1,12 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
 
 #include "instruction/instruction_format.h"
 #include "tracker/tracker.h"
+#include "tracker/tracker_provider.h"
 #include "util/logger.h"
 
 namespace dkvr {
@@ -11,31 +14,60 @@ namespace dkvr {
 	class InstructionHandler
 	{
 	public:
-		void Handle(Tracker* target, Instruction& inst);
+		InstructionHandler(TrackerProvider& tk_provider) : tk_provider_(tk_provider) { }
+
+		/// <summary>
+		/// Dispatch by opcode table, instructions below the required connection status or with malformed payload are dropped
+		/// before reaching the handler. received is the receive timestamp of the datagram in steady_clock nanoseconds.
+		/// </summary>
+		void Handle(Tracker* target, Instruction& inst, int64_t received);
 
 	private:
-		void Handshake1(Tracker* target, Instruction& inst);
-		void Handshake2(Tracker* target, Instruction& inst);
-		void Heartbeat(Tracker* target, Instruction& inst);
-		void Ping(Tracker* target, Instruction& inst);
-		void Pong(Tracker* target, Instruction& inst);
-
-		void Locate(Tracker* target, Instruction& inst);
-		void ClientName(Tracker* target, Instruction& inst);
-
-		void Behavior(Tracker* target, Instruction& inst);
-		void GyrTransform(Tracker* target, Instruction& inst);
-		void AccTransform(Tracker* target, Instruction& inst);
-		void MagTransform(Tracker* target, Instruction& inst);
-		void NoiseVariance(Tracker* target, Instruction& inst);
-
-		void Status(Tracker* target, Instruction& inst);
-		void Raw(Tracker* target, Instruction& inst);
-		void Nominal(Tracker* target, Instruction& inst);
-		void Statistic(Tracker* target, Instruction& inst);
-		void Debug(Tracker* target, Instruction& inst);
+		using HandlerFunc = void (InstructionHandler::*)(Tracker* target, Instruction& inst, int64_t received);
+
+		struct OpcodeEntry
+		{
+			HandlerFunc handler;						// nullptr for unknown opcode
+			Tracker::ConnectionStatus min_connection;
+			uint8_t min_length;							// payload bytes
+			uint8_t align;								// 0 for any
+		};
+
+		// table of Handle(), indexed by opcode
+		static constexpr std::array<OpcodeEntry, 256> BuildOpcodeTable();
+
+		void Handshake1(Tracker* target, Instruction& inst, int64_t received);
+		void Handshake2(Tracker* target, Instruction& inst, int64_t received);
+		void Heartbeat(Tracker* target, Instruction& inst, int64_t received);
+		void Ping(Tracker* target, Instruction& inst, int64_t received);
+		void Pong(Tracker* target, Instruction& inst, int64_t received);
+
+		void Locate(Tracker* target, Instruction& inst, int64_t received);
+		void ClientName(Tracker* target, Instruction& inst, int64_t received);
 
+		void Behavior(Tracker* target, Instruction& inst, int64_t received);
+		void GyrTransform(Tracker* target, Instruction& inst, int64_t received);
+		void AccTransform(Tracker* target, Instruction& inst, int64_t received);
+		void MagTransform(Tracker* target, Instruction& inst, int64_t received);
+		void NoiseVariance(Tracker* target, Instruction& inst, int64_t received);
+
+		void Status(Tracker* target, Instruction& inst, int64_t received);
+		void Raw(Tracker* target, Instruction& inst, int64_t received);
+		void Nominal(Tracker* target, Instruction& inst, int64_t received);
+		void Statistic(Tracker* target, Instruction& inst, int64_t received);
+		void RawBatch(Tracker* target, Instruction& inst, int64_t received);
+		void NominalBatch(Tracker* target, Instruction& inst, int64_t received);
+		void NominalCompact(Tracker* target, Instruction& inst, int64_t received);
+		void Debug(Tracker* target, Instruction& inst, int64_t received);
+
+		void LogMalformed(const Tracker* target, const Instruction& inst);
+
+		TrackerProvider& tk_provider_;
 		Logger& logger_ = Logger::GetInstance();
+
+		// limited per tracker address
+		LogRateLimiter unknown_opcode_log_limit_;
+		LogRateLimiter malformed_log_limit_;
 	};
 
 }	// namespace dkvr
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "export/dkvr_pose_shm.h"
+
+#include "tracker/tracker_provider.h"
+#include "util/logger.h"
+#include "util/thread_container.h"
+
+namespace dkvr {
+
+	/// <summary>
+	/// Publish latest data of every tracker into a shared memory segment for out-of-process readers.
+	/// Layout is defined in export/dkvr_pose_shm.h, each slot is guarded by its own seqlock.
+	/// </summary>
+	class PosePublisher
+	{
+	public:
+		PosePublisher(TrackerProvider& tk_provider);
+		~PosePublisher();
+
+		/// <summary>
+		/// Create the segment and launch publisher thread, returns 0 if succeeded.
+		/// </summary>
+		int Run(const std::string& name);
+		void Stop();
+		bool IsRunning() const { return publisher_thread_.IsRunning(); }
+
+	private:
+		PosePublisher(const PosePublisher&) = delete;
+		PosePublisher(PosePublisher&&) = delete;
+		void operator= (const PosePublisher&) = delete;
+		void operator= (PosePublisher&&) = delete;
+
+		int MapSegment();
+		void UnmapSegment();
+		void PublishPoses();
+		void WriteSlot(DKVRPoseSlot* slot, const TrackerSnapshot& snapshot);
+
+		DKVRPoseShmHeader* header() const { return static_cast<DKVRPoseShmHeader*>(segment_); }
+		DKVRPoseSlot* slot(size_t index) const;
+
+		ThreadContainer<PosePublisher> publisher_thread_;
+
+		std::string name_;
+		void* segment_;
+		size_t segment_size_;
+#ifdef _WIN32
+		void* mapping_handle_;
+#else
+		int shm_fd_;
+#endif
+
+		// skip the slots which have nothing new
+		int64_t last_timestamp_[DKVR_POSE_SHM_SLOT_CAPACITY];
+		uint32_t last_connection_[DKVR_POSE_SHM_SLOT_CAPACITY];
+
+		TrackerProvider& tk_provider_;
+		Logger& logger_ = Logger::GetInstance();
+	};
+
+}	// namespace dkvr
\ No newline at end of file
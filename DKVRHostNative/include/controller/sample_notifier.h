@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "tracker/sample_history.h"
+#include "tracker/tracker_provider.h"
+#include "util/logger.h"
+
+namespace dkvr {
+
+	/// <summary>
+	/// Notify consumers of newly received samples, either by callback or by waking up the waiting threads.
+	/// Tracker index is mapped to a bit of 64-bit mask, index above 63 shares the last bit.
+	/// </summary>
+	class SampleNotifier
+	{
+	public:
+		using Callback = void(*)(void* context, int index, const TimedSample& sample);
+
+		static constexpr size_t kMaskBits = 64;
+
+		SampleNotifier(const TrackerProvider& tk_provider);
+
+		/// <summary>
+		/// Callback is invoked on a dispatcher worker after the tracker is released, one call at a time, pass nullptr to unregister.
+		/// Once this returns, the previous callback is never invoked again. Do not call this from inside the callback.
+		/// </summary>
+		void RegisterCallback(Callback callback, void* context);
+
+		/// <summary>
+		/// Block until a sample of any tracker in mask arrives after the call, or timeout expires.
+		/// Returns false on timeout.
+		/// </summary>
+		bool WaitForSamples(std::chrono::milliseconds timeout, uint64_t mask);
+
+		// called by dispatcher with the history range [begin, end) just written
+		void Notify(int index, uint64_t begin, uint64_t end);
+
+		// unblock every waiting thread, used on shutdown
+		void WakeupAll();
+
+	private:
+		SampleNotifier(const SampleNotifier&) = delete;
+		SampleNotifier(SampleNotifier&&) = delete;
+		void operator= (const SampleNotifier&) = delete;
+		void operator= (SampleNotifier&&) = delete;
+
+		static size_t BitOf(size_t index) { return index < kMaskBits ? index : kMaskBits - 1; }
+
+		void InvokeCallback(int index, uint64_t begin, uint64_t end);
+
+		// callback, workers take the lock only while a callback is registered
+		std::mutex callback_mutex_;
+		std::atomic_bool callback_registered_;
+		Callback callback_;
+		void* callback_context_;
+
+		// waiters compare these counters against the snapshot taken at the beginning of the wait
+		std::atomic_uint64_t counters_[kMaskBits];
+		std::atomic_uint64_t wakeup_count_;
+		std::atomic_int waiters_;
+		std::mutex wait_mutex_;
+		std::condition_variable wait_cv_;
+
+		const TrackerProvider& tk_provider_;
+		Logger& logger_ = Logger::GetInstance();
+	};
+
+}	// namespace dkvr
\ No newline at end of file
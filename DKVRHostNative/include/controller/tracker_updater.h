@@ -1,14 +1,35 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 
 #include "network/network_service.h"
 #include "tracker/tracker_provider.h"
+#include "util/event_tracer.h"
 #include "util/logger.h"
+#include "util/ring_buffer.h"
 #include "util/thread_container.h"
+#include "util/timer_wheel.h"
 
 namespace dkvr {
 
+	struct ConfigSyncStatistic
+	{
+		uint64_t synced;			// keys acknowledged by the client
+		uint64_t transmissions;		// configuration packets sent, including retransmissions
+		uint64_t retransmissions;
+		uint32_t last_latency_ms;	// first transmission to acknowledgement
+		uint32_t max_latency_ms;
+	};
+
+	/// <summary>
+	/// <para>Keeps connection of trackers alive and sends periodic requests.</para>
+	/// <para>Every tracker has its own deadlines on a timer wheel, the thread sleeps until the earliest one
+	/// and locks only the trackers which are due.</para>
+	/// </summary>
 	class TrackerUpdater
 	{
 	public:
@@ -17,21 +38,92 @@ namespace dkvr {
 		void Run();
 		void Stop();
 
+		/// <summary>
+		/// Reschedule the tracker right away, call this when connection status, configuration or request of it has been changed.
+		/// Never takes the tracker lock, safe to call while holding an AtomicTracker.
+		/// </summary>
+		void RequestUpdate(int index);
+
+		/// <summary>
+		/// Configuration sync metrics of the tracker, readable from any thread.
+		/// </summary>
+		ConfigSyncStatistic GetConfigSyncStatistic(int index) const;
+
 	private:
+		using Clock = std::chrono::steady_clock;
+
+		enum TimerKind : uint32_t
+		{
+			kConnection,	// handshake, timeout
+			kHeartbeat,
+			kPing,
+			kStatus,		// status and statistic
+			kRequest,		// update requests
+			kConfig,		// configuration sync and retransmission
+			kTimerKindCount
+		};
+
+		using ConfigurationKey = TrackerConfiguration::ConfigurationKey;
+		static constexpr size_t kConfigKeyCount = static_cast<size_t>(ConfigurationKey::Size);
+
+		// per-key retransmission state, owned by the updater thread
+		struct ConfigSyncState
+		{
+			Clock::time_point first_sent;
+			Clock::time_point retransmit_at;
+			uint32_t revision;		// configuration revision being sent
+			uint16_t attempts;
+			bool in_flight;
+		};
+
+		struct AtomicConfigSyncStatistic
+		{
+			std::atomic_uint64_t synced;
+			std::atomic_uint64_t transmissions;
+			std::atomic_uint64_t retransmissions;
+			std::atomic_uint32_t last_latency_ms;
+			std::atomic_uint32_t max_latency_ms;
+		};
+
+		static constexpr size_t kRequestQueueSize = 256;
+
 		void UpdateTracker();
+		void HandleRequests();
+		void OnTimer(TimerWheel::Timer& timer);
+		void Schedule(int index, TimerKind kind, Clock::time_point deadline);
 
-		void UpdateConnection(Tracker* target);
-		void UpdateHeartbeatAndRtt(Tracker* target);
+		void UpdateConnection(int index, Tracker* target);
+		void UpdateHeartbeat(int index, Tracker* target);
+		void UpdateRtt(int index, Tracker* target);
 		void HandleUpdateRequired(Tracker* target);
-		void SyncConfigurationWithClient(Tracker* target);
+		Clock::time_point SyncConfigurationWithClient(int index, Tracker* target);
+		void SendConfiguration(Tracker* target, ConfigurationKey key);
+		void ReleaseConfigSync(int index);
 		void UpdateStatusAndStatistic(Tracker* target);
+		// queue inst to target and count it on its network counters
+		void Send(Tracker* target, Instruction& inst);
 
-		std::chrono::steady_clock::time_point now_;
+		Clock::time_point now_;
+		TimerWheel wheel_;
+		TimerWheel::Timer timers_[TrackerProvider::kMaxTrackers][kTimerKindCount];
+		size_t known_count_;
+		ConfigSyncState config_sync_[TrackerProvider::kMaxTrackers][kConfigKeyCount];
+		size_t config_in_flight_;		// every tracker
+		AtomicConfigSyncStatistic config_stat_[TrackerProvider::kMaxTrackers];
 		ThreadContainer<TrackerUpdater> updater_thread_;
 
+		// update requests from other threads, rescan every tracker if the queue overflows
+		RingBuffer<int, kRequestQueueSize, OverflowPolicy::DropNewest> requests_;
+		std::atomic_bool rescan_required_;
+		std::atomic_bool stopping_;
+		bool wakeup_;
+		std::mutex wakeup_mutex_;
+		std::condition_variable wakeup_cv_;
+
 		NetworkService& net_service_;
 		TrackerProvider& tk_provider_;
 		Logger& logger_ = Logger::GetInstance();
+		EventTracer& tracer_ = EventTracer::GetInstance();
 	};
 
 }	// namespace dkvr
\ No newline at end of file
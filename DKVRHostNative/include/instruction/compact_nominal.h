@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DKVR_COMPACT_NOMINAL_SSE2
+#endif
+
+#include "instruction/instruction_format.h"
+#include "tracker/tracker_data.h"
+
+namespace dkvr {
+
+	/**
+	 * @brief Compact wire format of NominalDataSet used by protocol v3, 19 bytes instead of 40.
+	 *
+	 * Orientation is quantized with smallest-three: the index of the largest component in 2 bits and the other three
+	 * in 18 bits each, packed little endian into 7 bytes. The quaternion is sign-flipped so the dropped component is
+	 * positive, then it is restored from the unit norm. Linear acceleration and magnetic disturbance follow as
+	 * little endian int16 fixed point. Every field is read byte by byte, so the frame needs no byte order conversion.
+	 */
+	class CompactNominal
+	{
+	public:
+		static constexpr size_t kOrientationSize = 7;
+		static constexpr size_t kEncodedSize = kOrientationSize + 6 * sizeof(int16_t);
+
+		static constexpr float kLinearAccelerationScale = 1.0f / 1024.0f;	// range of +-32
+		static constexpr float kMagneticDisturbanceScale = 1.0f / 256.0f;	// range of +-128
+
+		static void Encode(const NominalDataSet& src, uint8_t* dst)
+		{
+			Quaternionf q = src.orientation;
+			float norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+			if (norm > 0.0f)
+			{
+				for (int i = 0; i < 4; i++)
+					q[i] /= norm;
+			}
+			else
+			{
+				q = Quaternionf{ 1.0f, 0.0f, 0.0f, 0.0f };
+			}
+
+			int largest = 0;
+			for (int i = 1; i < 4; i++)
+				if (std::fabs(q[i]) > std::fabs(q[largest]))
+					largest = i;
+			float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+			uint64_t bits = static_cast<uint64_t>(largest);
+			for (int j = 0; j < 3; j++)
+				bits |= static_cast<uint64_t>(QuantizeComponent(q[kOthers[largest][j]] * sign)) << (kIndexBits + j * kComponentBits);
+			for (size_t i = 0; i < kOrientationSize; i++)
+				dst[i] = static_cast<uint8_t>(bits >> (i * 8));
+
+			uint8_t* ptr = dst + kOrientationSize;
+			for (int i = 0; i < 3; i++, ptr += sizeof(int16_t))
+				WriteFixed(ptr, src.linear_acceleration[i], kLinearAccelerationScale);
+			for (int i = 0; i < 3; i++, ptr += sizeof(int16_t))
+				WriteFixed(ptr, src.magnetic_disturbance[i], kMagneticDisturbanceScale);
+		}
+
+		static void Decode(const uint8_t* src, NominalDataSet& dst)
+		{
+			uint64_t bits = 0;
+			for (size_t i = 0; i < kOrientationSize; i++)
+				bits |= static_cast<uint64_t>(src[i]) << (i * 8);
+
+			int largest = static_cast<int>(bits & kIndexMask);
+			float c[3];
+			for (int j = 0; j < 3; j++)
+				c[j] = DequantizeComponent(static_cast<uint32_t>(bits >> (kIndexBits + j * kComponentBits)) & kComponentMask);
+
+			float dropped = std::sqrt(std::max(0.0f, 1.0f - (c[0] * c[0] + c[1] * c[1] + c[2] * c[2])));
+			PlaceOrientation(dst.orientation, largest, c[0], c[1], c[2], dropped);
+
+			const uint8_t* ptr = src + kOrientationSize;
+			for (int i = 0; i < 3; i++, ptr += sizeof(int16_t))
+				dst.linear_acceleration[i] = ReadFixed(ptr) * kLinearAccelerationScale;
+			for (int i = 0; i < 3; i++, ptr += sizeof(int16_t))
+				dst.magnetic_disturbance[i] = ReadFixed(ptr) * kMagneticDisturbanceScale;
+		}
+
+		/**
+		 * @brief Decode count samples placed stride bytes apart, same result as Decode on each of them.
+		 *
+		 * Fields are gathered into lanes of kLanes samples first, so dequantization and quaternion reconstruction
+		 * run four samples per SSE2 instruction (or as a plain loop the compiler can vectorize).
+		 */
+		static void DecodeBatch(const uint8_t* src, size_t stride, size_t count, NominalDataSet* dst)
+		{
+			for (size_t base = 0; base < count; base += kLanes)
+			{
+				size_t n = std::min(kLanes, count - base);
+
+				// gather, conversion runs four lanes at a time so padding lanes are zeroed and never written back
+				size_t lanes = (n + 3) & ~size_t(3);
+				alignas(16) int32_t component[3][kLanes];
+				alignas(16) int32_t fixed[6][kLanes];
+				int largest[kLanes];
+				for (size_t k = n; k < lanes; k++)
+				{
+					for (int j = 0; j < 3; j++) component[j][k] = 0;
+					for (int f = 0; f < 6; f++) fixed[f][k] = 0;
+				}
+				for (size_t k = 0; k < n; k++)
+				{
+					const uint8_t* ptr = src + (base + k) * stride;
+					uint64_t bits = 0;
+					for (size_t i = 0; i < kOrientationSize; i++)
+						bits |= static_cast<uint64_t>(ptr[i]) << (i * 8);
+
+					largest[k] = static_cast<int>(bits & kIndexMask);
+					for (int j = 0; j < 3; j++)
+						component[j][k] = static_cast<int32_t>(bits >> (kIndexBits + j * kComponentBits)) & kComponentMask;
+
+					ptr += kOrientationSize;
+					for (int f = 0; f < 6; f++, ptr += sizeof(int16_t))
+						fixed[f][k] = ReadFixed(ptr);
+				}
+
+				// convert
+				alignas(16) float c[3][kLanes];
+				alignas(16) float dropped[kLanes];
+				alignas(16) float scaled[6][kLanes];
+				DequantizeLanes(lanes, component, fixed, c, dropped, scaled);
+
+				// scatter
+				for (size_t k = 0; k < n; k++)
+				{
+					NominalDataSet& out = dst[base + k];
+					PlaceOrientation(out.orientation, largest[k], c[0][k], c[1][k], c[2][k], dropped[k]);
+					for (int i = 0; i < 3; i++)
+					{
+						out.linear_acceleration[i] = scaled[i][k];
+						out.magnetic_disturbance[i] = scaled[i + 3][k];
+					}
+				}
+			}
+		}
+
+	private:
+		static constexpr size_t kLanes = 16;
+		static constexpr int kIndexBits = 2;
+		static constexpr int kComponentBits = 18;
+		static constexpr uint64_t kIndexMask = (1u << kIndexBits) - 1;
+		static constexpr int32_t kComponentMask = (1 << kComponentBits) - 1;
+		static constexpr float kComponentLimit = 0.70710678f;		// 1 / sqrt(2), bound of every component but the largest
+		static constexpr float kComponentStep = 2.0f * kComponentLimit / kComponentMask;
+
+		// order of the transmitted components for each dropped index
+		static constexpr int kOthers[4][3] = { {1, 2, 3}, {0, 2, 3}, {0, 1, 3}, {0, 1, 2} };
+		// inverse of kOthers, where w, x, y, z come from in {c0, c1, c2, dropped}
+		static constexpr int kPlacement[4][4] = { {3, 0, 1, 2}, {0, 3, 1, 2}, {0, 1, 3, 2}, {0, 1, 2, 3} };
+
+		static_assert(kIndexBits + 3 * kComponentBits <= kOrientationSize * 8);
+		static_assert(kLanes % 4 == 0);
+
+		static uint32_t QuantizeComponent(float value)
+		{
+			float clamped = std::clamp(value, -kComponentLimit, kComponentLimit);
+			return static_cast<uint32_t>(std::lround((clamped + kComponentLimit) / kComponentStep));
+		}
+
+		static float DequantizeComponent(uint32_t value)
+		{
+			return static_cast<float>(value) * kComponentStep - kComponentLimit;
+		}
+
+		// every component is written once at a fixed position, cheaper than storing through the dropped index
+		static void PlaceOrientation(Quaternionf& q, int largest, float c0, float c1, float c2, float dropped)
+		{
+			const float gathered[4] = { c0, c1, c2, dropped };
+			const int* placement = kPlacement[largest];
+			for (int i = 0; i < 4; i++)
+				q[i] = gathered[placement[i]];
+		}
+
+		static void WriteFixed(uint8_t* dst, float value, float scale)
+		{
+			long fixed = std::clamp(std::lround(value / scale), static_cast<long>(INT16_MIN), static_cast<long>(INT16_MAX));
+			uint16_t raw = static_cast<uint16_t>(static_cast<int16_t>(fixed));
+			dst[0] = static_cast<uint8_t>(raw);
+			dst[1] = static_cast<uint8_t>(raw >> 8);
+		}
+
+		static int16_t ReadFixed(const uint8_t* src)
+		{
+			return static_cast<int16_t>(static_cast<uint16_t>(src[0] | (src[1] << 8)));
+		}
+
+		static void DequantizeLanes(size_t lanes, const int32_t (&component)[3][kLanes], const int32_t (&fixed)[6][kLanes],
+			float (&c)[3][kLanes], float (&dropped)[kLanes], float (&scaled)[6][kLanes])
+		{
+#ifdef DKVR_COMPACT_NOMINAL_SSE2
+			const __m128 step = _mm_set1_ps(kComponentStep);
+			const __m128 limit = _mm_set1_ps(kComponentLimit);
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 zero = _mm_setzero_ps();
+			for (size_t k = 0; k < lanes; k += 4)
+			{
+				__m128 sum = zero;
+				for (int j = 0; j < 3; j++)
+				{
+					__m128i raw = _mm_load_si128(reinterpret_cast<const __m128i*>(&component[j][k]));
+					__m128 value = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(raw), step), limit);
+					_mm_store_ps(&c[j][k], value);
+					sum = _mm_add_ps(sum, _mm_mul_ps(value, value));
+				}
+				_mm_store_ps(&dropped[k], _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(one, sum))));
+
+				for (int f = 0; f < 6; f++)
+				{
+					__m128i raw = _mm_load_si128(reinterpret_cast<const __m128i*>(&fixed[f][k]));
+					__m128 scale = _mm_set1_ps(f < 3 ? kLinearAccelerationScale : kMagneticDisturbanceScale);
+					_mm_store_ps(&scaled[f][k], _mm_mul_ps(_mm_cvtepi32_ps(raw), scale));
+				}
+			}
+#else
+			for (int j = 0; j < 3; j++)
+				for (size_t k = 0; k < lanes; k++)
+					c[j][k] = static_cast<float>(component[j][k]) * kComponentStep - kComponentLimit;
+			for (size_t k = 0; k < lanes; k++)
+				dropped[k] = std::sqrt(std::max(0.0f, 1.0f - (c[0][k] * c[0][k] + c[1][k] * c[1][k] + c[2][k] * c[2][k])));
+			for (int f = 0; f < 6; f++)
+				for (size_t k = 0; k < lanes; k++)
+					scaled[f][k] = static_cast<float>(fixed[f][k]) * (f < 3 ? kLinearAccelerationScale : kMagneticDisturbanceScale);
+#endif
+		}
+	};
+
+	// protocol v3 compact nominal frame, count byte followed by count samples in order of oldest first
+	// each sample is a little endian uint16 age in microseconds followed by the encoded data set, sent with align 1
+	inline constexpr size_t kCompactSampleSize = sizeof(uint16_t) + CompactNominal::kEncodedSize;
+	inline constexpr size_t kMaxCompactSamples = (kMaxPayloadSize - 1 - sizeof(uint8_t)) / kCompactSampleSize;
+
+}	// namespace dkvr
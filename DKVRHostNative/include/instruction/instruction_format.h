@@ -1,10 +1,16 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <type_traits>
 
 namespace dkvr {
 
+	// payload of protocol v1, every instruction except batched data frames fits in this
+	inline constexpr size_t kBasePayloadSize = 52;
+	// length field is a byte, batched data frames of protocol v2 are limited by this
+	inline constexpr size_t kMaxPayloadSize = 256;
+
 	union BytePack {
 		uint8_t uchar[4];
 		uint16_t ushort[2];
@@ -19,9 +25,14 @@ namespace dkvr {
 		uint8_t align;
 		uint8_t opcode;
 		uint32_t sequence;
-		BytePack payload[13];
+		BytePack payload[kMaxPayloadSize / sizeof(BytePack)];
 	};
 
+	// bytes before the payload, datagram on the wire is this plus length
+	inline constexpr size_t kInstructionHeaderSize = offsetof(Instruction, payload);
+
+	// any length the byte can hold fits in the payload, received length needs no bound check against it
+	static_assert(kMaxPayloadSize > UINT8_MAX);
 	static_assert(std::is_trivial_v<Instruction>);
 	static_assert(std::is_standard_layout_v<Instruction>);
 
@@ -1,13 +1,25 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
+#include "instruction/compact_nominal.h"
 #include "instruction/instruction_format.h"
+#include "tracker/tracker_data.h"
+#include "tracker/tracker_debug.h"
+#include "tracker/tracker_statistic.h"
+#include "tracker/tracker_status.h"
 
 namespace dkvr {
 
 	inline constexpr uint8_t kOpenerValue = 'D';
 
+	// client sends its highest version in Handshake1 (empty payload means v1), host answers the version in use with Handshake2
+	inline constexpr uint8_t kProtocolVersion1 = 1;
+	inline constexpr uint8_t kProtocolVersion2 = 2;		// batched data frames
+	inline constexpr uint8_t kProtocolVersion3 = 3;		// compact nominal frames
+	inline constexpr uint8_t kProtocolVersion = kProtocolVersion3;
+
 	enum class Opcode : uint8_t
 	{
 		// networking op
@@ -33,14 +45,39 @@ namespace dkvr {
 		Raw				= 0x32,
 		Nominal			= 0x33,
 		Statistic		= 0x34,
+		RawBatch		= 0x35,		// protocol v2
+		NominalBatch	= 0x36,		// protocol v2
+		NominalCompact	= 0x37,		// protocol v3
 		Debug			= 0x3F
 	};
 
+	// protocol v2 batched data frame, header followed by count samples in order of oldest first
+	// every field is 4 bytes, so the frame is sent with align 4
+	struct SampleBatchHeader
+	{
+		uint32_t count;
+	};
+
+	template <typename T>
+	struct BatchedSample
+	{
+		uint32_t age_us;	// microseconds elapsed since the sample was taken until the frame was sent
+		T data;
+	};
+
+	template <typename T>
+	inline constexpr size_t kMaxBatchSamples = (kMaxPayloadSize - 1 - sizeof(SampleBatchHeader)) / sizeof(BatchedSample<T>);
+	template <typename T>
+	inline constexpr uint8_t kMinBatchLength = sizeof(SampleBatchHeader) + sizeof(BatchedSample<T>);
+
 	struct InstructionHint
 	{
 		Opcode opcode;
 		uint8_t align;
 		uint8_t arg_count;
+		// payload the client sends with this opcode, at least reply_length bytes, reply_align 0 accepts any align
+		uint8_t reply_align = 0;
+		uint8_t reply_length = 0;
 
 		constexpr uint8_t length() const { return align * arg_count; }
 		constexpr Instruction ToInstruction() const
@@ -65,8 +102,9 @@ namespace dkvr {
 		static constexpr uint8_t kClassConfiguration = 0x20;
 		static constexpr uint8_t kClassDataTransfer = 0x30;
 
+		// handshake1 carries the client version or nothing (v1), handshake2 is sent by host only
 		static constexpr InstructionHint Handshake1{ Opcode::Handshake1, 0, 0 };
-		static constexpr InstructionHint Handshake2{ Opcode::Handshake2, 0, 0 };
+		static constexpr InstructionHint Handshake2{ Opcode::Handshake2, 1, 1 };
 		static constexpr InstructionHint Heartbeat{ Opcode::Heartbeat, 0, 0 };
 		static constexpr InstructionHint Ping{ Opcode::Ping, 0, 0 };
 		static constexpr InstructionHint Pong{ Opcode::Pong, 0, 0 };
@@ -74,17 +112,27 @@ namespace dkvr {
 		static constexpr InstructionHint Locate{ Opcode::Locate, 0, 0 };
 		static constexpr InstructionHint ClientName{ Opcode::ClientName, 0, 0 };
 
-		static constexpr InstructionHint Behavior{ Opcode::Behavior, 1, 1 };
-		static constexpr InstructionHint CalibrationGr{ Opcode::GyrTransform, 4, 12 };
-		static constexpr InstructionHint CalibrationAc{ Opcode::AccTransform, 4, 12 };
-		static constexpr InstructionHint CalibrationMg{ Opcode::MagTransform, 4, 12 };
-		static constexpr InstructionHint NoiseVariance{ Opcode::NoiseVariance, 4, 9 };
-
-		static constexpr InstructionHint Status{ Opcode::Status, 0, 0 };
-		static constexpr InstructionHint Raw{ Opcode::Raw, 0, 0 };
-		static constexpr InstructionHint Nominal{ Opcode::Nominal, 0, 0 };
-		static constexpr InstructionHint Statistic{ Opcode::Statistic, 0, 0 };
-		static constexpr InstructionHint Debug{ Opcode::Debug, 0, 0 };
+		// client echoes behavior as is and the pearson hash of the others
+		static constexpr InstructionHint Behavior{ Opcode::Behavior, 1, 1, 0, 1 };
+		static constexpr InstructionHint CalibrationGr{ Opcode::GyrTransform, 4, 12, 0, sizeof(uint8_t) };
+		static constexpr InstructionHint CalibrationAc{ Opcode::AccTransform, 4, 12, 0, sizeof(uint8_t) };
+		static constexpr InstructionHint CalibrationMg{ Opcode::MagTransform, 4, 12, 0, sizeof(uint8_t) };
+		static constexpr InstructionHint NoiseVariance{ Opcode::NoiseVariance, 4, 9, 0, sizeof(uint8_t) };
+
+		// data transfer is requested empty, float payload of the reply must be aligned for byte order conversion
+		static constexpr InstructionHint Status{ Opcode::Status, 0, 0, 0, sizeof(TrackerStatus) };
+		static constexpr InstructionHint Raw{ Opcode::Raw, 0, 0, sizeof(float), sizeof(RawDataSet) };
+		static constexpr InstructionHint Nominal{ Opcode::Nominal, 0, 0, sizeof(float), sizeof(NominalDataSet) };
+		static constexpr InstructionHint Statistic{ Opcode::Statistic, 0, 0, 0, sizeof(TrackerStatistic) };
+		static constexpr InstructionHint Debug{ Opcode::Debug, 0, 0, 0, offsetof(TrackerDebug, msg) };
+
+		// sent by client only
+		static constexpr InstructionHint RawBatch{ Opcode::RawBatch, 0, 0, sizeof(float), kMinBatchLength<RawDataSet> };
+		static constexpr InstructionHint NominalBatch{ Opcode::NominalBatch, 0, 0, sizeof(float), kMinBatchLength<NominalDataSet> };
+		static constexpr InstructionHint NominalCompact{ Opcode::NominalCompact, 0, 0, 1, sizeof(uint8_t) + kCompactSampleSize };
 	};
 
+	static_assert(sizeof(RawDataSet) <= kBasePayloadSize);
+	static_assert(sizeof(NominalDataSet) <= kBasePayloadSize);
+
 }	// namespace dkvr
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "tracker/tracker_data.h"
+#include "tracker/tracker_provider.h"
+
+namespace dkvr {
+
+	/// <summary>
+	/// <para>Estimates the orientation of trackers at an arbitrary steady_clock timestamp.</para>
+	/// <para>Between the two latest nominal samples the orientation is slerp-interpolated,
+	/// after the latest one it is extrapolated with the angular velocity derived from those two samples.</para>
+	/// <para>Reads the sample history only, so it never takes any lock nor allocates.</para>
+	/// </summary>
+	class PosePredictor
+	{
+	public:
+		// extrapolation beyond this is clamped, a stalled tracker must not keep spinning
+		static constexpr std::chrono::milliseconds kMaxPredictionHorizon{ 50 };
+
+		PosePredictor(const TrackerProvider& tk_provider) : tk_provider_(tk_provider) { }
+
+		/// <summary>
+		/// Returns false if tracker does not exist, out is left untouched in that case.
+		/// If less than two nominal samples are available, the latest orientation is returned as is.
+		/// </summary>
+		bool Predict(int index, int64_t timestamp, Quaternionf& out) const;
+
+		/// <summary>
+		/// Predict every tracker in index order, returns the number of orientations written.
+		/// </summary>
+		size_t PredictAll(int64_t timestamp, Quaternionf* out, size_t capacity) const;
+
+		static Quaternionf Slerp(const Quaternionf& from, const Quaternionf& to, float t);
+		static Quaternionf Extrapolate(const Quaternionf& from, const Quaternionf& to, float t);
+
+	private:
+		const TrackerProvider& tk_provider_;
+	};
+
+}	// namespace dkvr
\ No newline at end of file
@@ -1,15 +1,25 @@
 #pragma once
 
+#include <cstdint>
 #include <type_traits>
 
 #include "instruction/instruction_format.h"
 
 namespace dkvr {
 
+	// steady_clock nanoseconds, unused for sending
+	struct DatagramTimestamp
+	{
+		int64_t received;	// taken by the kernel where available, otherwise by the network thread
+		int64_t queued;		// placed to the receiving queue
+		int64_t popped;		// taken out of the receiving queue
+	};
+
 	struct Datagram
 	{
 		unsigned long address;
 		Instruction buffer;
+		DatagramTimestamp timestamp;
 	};
 
 	static_assert(std::is_trivial_v<Datagram>);
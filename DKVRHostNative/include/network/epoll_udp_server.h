@@ -0,0 +1,94 @@
+#pragma once
+
+#ifdef __linux__
+#	include <netinet/in.h>
+#	include <sys/epoll.h>
+#	include <sys/socket.h>
+#	include <sys/uio.h>
+#	include <time.h>
+#else
+#	error "Do not include this header in non-Linux OS."
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "network/udp_server.h"
+#include "util/event_tracer.h"
+#include "util/logger.h"
+#include "util/pipeline_latency.h"
+#include "util/thread_container.h"
+
+// maximum datagrams handled by one recvmmsg()/sendmmsg() call
+#ifndef DKVR_EPOLL_BATCH_SIZE
+#	define DKVR_EPOLL_BATCH_SIZE	16
+#endif
+
+namespace dkvr {
+
+	class EpollUDPServer final : public UDPServer
+	{
+	public:
+		static constexpr size_t kBatchSize = DKVR_EPOLL_BATCH_SIZE;
+		static_assert(kBatchSize >= 1 && kBatchSize <= kMaxBatchSize);
+
+		explicit EpollUDPServer(PipelineLatency& latency);
+		~EpollUDPServer();
+
+		BatchStatistic batch_statistic() const override;
+
+	protected:
+		int InternalInit() override;
+		int InternalBind() override;
+		void InternalClose() override;
+		void InternalDeinit() override;
+		void InternalNotifySending() override;
+
+	private:
+		int CreateSocket();
+		void CloseSocket();
+		void ParseSocketError(int error);
+		void SendAndRecvMessage();
+
+		void PrepareBatch();
+		void HandleRecv();
+		int64_t ReceiveTimestamp(const msghdr& msg, int64_t steady_now, int64_t realtime_offset) const;
+		void FlushSending();
+		void SetWriteInterest(bool enable);
+		void DrainWakeupEvent();
+		void LogBatchStatistic() const;
+
+		ThreadContainer<EpollUDPServer> epoll_thread_;
+
+		int socket_;
+		int epoll_fd_;
+		int wakeup_fd_;
+		bool socket_binded_;
+		bool write_interest_;
+		bool kernel_timestamp_;		// SO_TIMESTAMPNS accepted by the socket
+
+		// preallocated batch buffers, recvmmsg()/sendmmsg() work directly on these
+		Datagram recv_batch_[kBatchSize];
+		sockaddr_in recv_addr_[kBatchSize];
+		iovec recv_iov_[kBatchSize];
+		mmsghdr recv_msgs_[kBatchSize];
+		alignas(cmsghdr) uint8_t recv_control_[kBatchSize][CMSG_SPACE(sizeof(timespec))];
+
+		Datagram send_batch_[kBatchSize];
+		sockaddr_in send_addr_[kBatchSize];
+		iovec send_iov_[kBatchSize];
+		mmsghdr send_msgs_[kBatchSize];
+		size_t send_begin_;		// first datagram of send_batch_ not sent yet
+		size_t send_end_;
+
+		// written by epoll thread only
+		std::atomic_uint64_t recv_fill_[kBatchSize + 1];
+		std::atomic_uint64_t send_fill_[kBatchSize + 1];
+
+		Logger& logger_ = Logger::GetInstance();
+		PipelineLatency& latency_;
+		EventTracer& tracer_ = EventTracer::GetInstance();
+	};
+
+}	// namespace dkvr
\ No newline at end of file
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 #include "network/datagram.h"
 #include "network/udp_server.h"
 #include "util/logger.h"
+#include "util/pipeline_latency.h"
 #include "util/thread_container.h"
 
 namespace dkvr 
@@ -13,14 +15,25 @@ namespace dkvr
 	class NetworkService final
 	{
 	public:
-		NetworkService();
+		// received instructions are split into receive_shards queues by sender address
+		// latency of the network thread is recorded to latency, which must outlive this
+		NetworkService(PipelineLatency& latency, size_t receive_shards = 1);
 		~NetworkService();
 
 		bool Run(unsigned long ip = 0, unsigned short port = 8899u);
 		void Stop();
-		bool WaitAndPopReceived(unsigned long& address_out, Instruction& inst_out);
-		void Send(unsigned long address, Instruction& inst);
+		bool WaitAndPopReceived(unsigned long& address_out, Instruction& inst_out, DatagramTimestamp& timestamp_out, size_t shard = 0);
+		// returns false if inst is not placed to the sending queue
+		bool Send(unsigned long address, Instruction& inst);
 		void RequestWakeup() { udp_->Wakeup(); }
+		size_t receive_shard_count() const { return udp_->shard_count(); }
+
+		// counters of the UDP server, lock-free
+		UDPServer::TrafficStatistic traffic_statistic() const        { return udp_->traffic_statistic(); }
+		UDPServer::InvalidDatagramStatistic invalid_statistic() const { return udp_->invalid_statistic(); }
+		UDPServer::BatchStatistic batch_statistic() const            { return udp_->batch_statistic(); }
+		uint64_t received_dropped() const  { return udp_->received_dropped(); }
+		uint64_t sending_dropped() const   { return udp_->sending_dropped(); }
 
 	private:
 		NetworkService(const NetworkService&) = delete;
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <memory>
 #include <mutex>
-#include <queue>
 
 #include "network/datagram.h"
 #include "util/logger.h"
+#include "util/ring_buffer.h"
+#include "util/spsc_ring_buffer.h"
 
 namespace dkvr 
 {
@@ -15,6 +19,41 @@ namespace dkvr
     public:
         static constexpr unsigned short kDefaultHostPort = 8899u;
         static constexpr unsigned short kDefaultClientPort = 8899u;
+        static constexpr size_t kReceivedQueueSize = 1024;
+        static constexpr size_t kSendingQueueSize = 256;
+        static constexpr size_t kMaxReceiveShards = 16;
+        static constexpr size_t kMaxBatchSize = 64;     // datagrams one syscall of any server may handle
+
+        // datagrams dropped at receive time, before reaching the queue
+        struct InvalidDatagramStatistic
+        {
+            uint64_t truncated;         // shorter than the instruction header
+            uint64_t wrong_opener;
+            uint64_t wrong_length;      // length field larger than the received payload
+            uint64_t unknown_opcode;    // opcode out of every known class
+        };
+
+        // every datagram passed through the socket, counted by the network thread
+        struct TrafficStatistic
+        {
+            uint64_t rx_packets;        // received, invalid ones included
+            uint64_t rx_bytes;
+            uint64_t tx_packets;        // accepted by the socket
+            uint64_t tx_bytes;
+            uint64_t send_errors;       // rejected by the socket and dropped
+        };
+
+        // per-batch fill of servers handling several datagrams per syscall, fill[n] counts the calls which handled exactly n
+        struct BatchStatistic
+        {
+            size_t batch_size;          // 0 if the server sends and receives one datagram per call
+            uint64_t recv_calls;        // calls which handled at least one datagram
+            uint64_t recv_datagrams;
+            uint64_t send_calls;
+            uint64_t send_datagrams;
+            uint64_t recv_fill[kMaxBatchSize + 1];
+            uint64_t send_fill[kMaxBatchSize + 1];
+        };
 
         enum class Status
         {
@@ -26,18 +65,32 @@ namespace dkvr
             Error
         };
 
-        UDPServer() : status_(Status::InitRequired), received_(), sending_(), mutex_(), convar_(), host_ip_(0), host_port_(kDefaultHostPort) { }
+        UDPServer() : status_(Status::InitRequired), shards_(), shard_count_(1), sending_(), host_ip_(0), host_port_(kDefaultHostPort) { }
         virtual ~UDPServer() { }
 
-        int Init();
+        /**
+         * @brief   Initialize the server with @a shard_count receiving queues.
+         *          Received datagrams are distributed by sender address, so datagrams of a sender always go to the same shard.
+         *          Each shard has its own consumer, clamped to [1, @c kMaxReceiveShards].
+         */
+        int Init(size_t shard_count = 1);
         int Bind(unsigned long ip, unsigned short port);
         void Close();
         void Deinit();
         int PushSending(const Datagram& dgram);
-        bool PeekReceived() const;
-        bool WaitReceived() const;
-        Datagram PopReceived();
-        void Wakeup() { convar_.notify_all(); }
+        bool PeekReceived(size_t shard = 0) const;
+        bool WaitReceived(size_t shard = 0) const;
+        Datagram PopReceived(size_t shard = 0);
+        // wake every consumer, one which is not parked yet returns from its next WaitReceived() at once
+        void Wakeup();
+        size_t ShardOf(unsigned long address) const;
+
+        uint64_t received_dropped() const;
+        InvalidDatagramStatistic invalid_statistic() const;
+        TrafficStatistic traffic_statistic() const;
+        virtual BatchStatistic batch_statistic() const { return BatchStatistic{}; }
+        uint64_t sending_dropped() const    { return sending_.dropped(); }
+        size_t   shard_count() const        { return shard_count_; }
 
         Status         status() const       { return status_; }
         unsigned short client_port() const  { return kDefaultClientPort; }	// actually it's public const
@@ -87,6 +140,13 @@ namespace dkvr
          */
         virtual int InternalHandleError() { return 1; }
 
+        /**
+         * @brief   Implementation specific.
+         *          Called right after a datagram is placed to the sending queue, this implementation is optional.
+         *          Event-driven implementation should wake up it's network thread here instead of polling @c PeekSending().
+         */
+        virtual void InternalNotifySending() { }
+
 
         /**
          * @brief   Check the queue waiting to be sent
@@ -104,11 +164,48 @@ namespace dkvr
         Datagram PopSending();
 
         /**
-         * @brief   Place @a dgram to sending queue.
-         * @param dgram     @c Datagram to be sent
+         * @brief   Pop up to @a max elements of the sending queue at once.
+         * @param out       destination array, must hold at least @a max elements
+         * @param max       maximum number of datagrams to pop
+         * @return  Number of datagrams popped, zero if queue is empty
+         */
+        size_t PopSending(Datagram* out, size_t max);
+
+        /**
+         * @brief   Check the header of @a dgram against the @a size bytes actually received.
+         *          Invalid datagram is counted and must be dropped by the caller, so that it never reaches the dispatcher.
+         * @param   truncated   datagram was larger than the buffer, counted as invalid length whatever the header says
+         * @return  true if @a dgram may be pushed to the receiving queue
+         */
+        bool ValidateReceived(const Datagram& dgram, size_t size, bool truncated = false);
+
+        /**
+         * @brief   Count @a count datagrams of @a bytes in total accepted by the socket.
+         */
+        void CountSent(size_t bytes, size_t count = 1)
+        {
+            tx_packets_.fetch_add(count, std::memory_order_relaxed);
+            tx_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief   Count a datagram dropped because the socket failed to send it.
+         */
+        void CountSendError() { send_errors_.fetch_add(1, std::memory_order_relaxed); }
+
+        /**
+         * @brief   Place @a dgram to receiving queue of its shard.
+         * @param dgram     @c Datagram received
          */
         void PushReceived(const Datagram& dgram);
 
+        /**
+         * @brief   Place @a count datagrams to receiving queues, each shard is notified once.
+         * @param dgrams    array of received @c Datagram
+         * @param count     number of elements of @a dgrams
+         */
+        void PushReceived(const Datagram* dgrams, size_t count);
+
         /**
          * @brief   Set UDP server status to @c Status::Error
          *          Implemented logic should be suspended until @c Bind() is explicitly called again.
@@ -135,11 +232,38 @@ namespace dkvr
         void operator= (const UDPServer&) = delete;
         void operator= (UDPServer&&) = delete;
 
+        // received datagrams are time-sensitive, newer one replaces the oldest on overflow
+        using ReceivedQueue = SpscRingBuffer<Datagram, kReceivedQueueSize>;
+        using SendingQueue = RingBuffer<Datagram, kSendingQueueSize, OverflowPolicy::DropNewest>;
+
+        struct alignas(kCacheLineSize) ReceivedShard
+        {
+            ReceivedQueue queue;                // single producer (network thread), single consumer (dispatcher worker)
+            mutable std::mutex mutex;           // guards nothing but the parking of the consumer
+            mutable std::condition_variable convar;
+            mutable std::atomic_bool consumer_parked = false;
+            mutable bool wakeup_requested = false;  // guarded by mutex, consumed by the next WaitReceived()
+        };
+
+        static void Wakeup(const ReceivedShard& shard);
+        static void NotifyConsumerIfParked(const ReceivedShard& shard);
+
         Status status_;
-        std::queue<Datagram> received_;
-        std::queue<Datagram> sending_;
-        mutable std::mutex mutex_;
-        mutable std::condition_variable convar_;
+        std::unique_ptr<ReceivedShard[]> shards_;
+        size_t shard_count_;
+        SendingQueue sending_;      // multiple producer, single consumer (network thread)
+
+        // written by network thread only
+        std::atomic_uint64_t invalid_truncated_ = 0;
+        std::atomic_uint64_t invalid_opener_ = 0;
+        std::atomic_uint64_t invalid_length_ = 0;
+        std::atomic_uint64_t invalid_opcode_ = 0;
+        std::atomic_uint64_t rx_packets_ = 0;
+        std::atomic_uint64_t rx_bytes_ = 0;
+        std::atomic_uint64_t tx_packets_ = 0;
+        std::atomic_uint64_t tx_bytes_ = 0;
+        std::atomic_uint64_t send_errors_ = 0;
+        LogRateLimiter invalid_log_limit_;
         unsigned long host_ip_;
         unsigned short host_port_;
 
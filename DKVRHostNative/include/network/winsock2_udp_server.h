@@ -7,7 +7,9 @@
 #endif
 
 #include "network/udp_server.h"
+#include "util/event_tracer.h"
 #include "util/logger.h"
+#include "util/pipeline_latency.h"
 #include "util/thread_container.h"
 
 namespace dkvr {
@@ -15,7 +17,7 @@ namespace dkvr {
 	class Winsock2UDPServer final : public UDPServer
 	{
 	public:
-		Winsock2UDPServer();
+		explicit Winsock2UDPServer(PipelineLatency& latency);
 		~Winsock2UDPServer();
 
 	protected:
@@ -40,6 +42,8 @@ namespace dkvr {
 		unsigned long binding_ip_;
 
 		Logger& logger_ = Logger::GetInstance();
+		PipelineLatency& latency_;
+		EventTracer& tracer_ = EventTracer::GetInstance();
 	};
 
 }	// namespace dkvr
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <mutex>
-#include <memory>
 
 #include "tracker/tracker.h"
 
@@ -16,7 +15,7 @@ namespace dkvr {
 	public:
 		AtomicTrackerBase() : target_(nullptr), lock_() { }
 		AtomicTrackerBase(AtomicTrackerBase&& ref) noexcept : target_(ref.target_), lock_(std::move(ref.lock_)) { }
-		AtomicTrackerBase(TrackerType* tracker, std::shared_ptr<std::mutex> ptr) : target_(tracker), lock_(*ptr) { }
+		AtomicTrackerBase(TrackerType* tracker, std::mutex& mutex) : target_(tracker), lock_(mutex) { }
 
 		bool IsNullptr() { return !target_; }
 
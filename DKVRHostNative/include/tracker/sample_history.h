@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "tracker/tracker_data.h"
+#include "util/ring_buffer.h"
+
+namespace dkvr {
+
+	enum class SampleKind : uint32_t
+	{
+		Raw,
+		Nominal
+	};
+
+	struct TimedSample
+	{
+		int64_t timestamp;		// host receive time, steady_clock nanoseconds
+		uint32_t sequence;		// device sequence number
+		SampleKind kind;
+		union
+		{
+			RawDataSet raw;
+			NominalDataSet nominal;
+		};
+	};
+
+	/// <summary>
+	/// Fixed-size history of received samples, older samples are overwritten.
+	/// Single writer (under the tracker lock), any number of wait-free readers each holding their own cursor.
+	/// Cursor is the absolute position of the next sample to read, it never wraps.
+	/// </summary>
+	class SampleHistory
+	{
+	public:
+		static constexpr size_t kCapacity = 1024;
+
+		SampleHistory() : head_(0), slots_{} { }
+
+		void Push(const TimedSample& sample)
+		{
+			uint64_t pos = head_.load(std::memory_order_relaxed);
+			Slot& slot = slots_[pos & kMask];
+
+			uint32_t words[kWordCount];
+			std::memcpy(words, &sample, sizeof(TimedSample));
+
+			// odd stamp marks the slot under writing
+			slot.stamp.store(pos * 2 + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (size_t i = 0; i < kWordCount; i++)
+				slot.words[i].store(words[i], std::memory_order_relaxed);
+			slot.stamp.store(pos * 2 + 2, std::memory_order_release);
+
+			head_.store(pos + 1, std::memory_order_release);
+		}
+
+		/// <summary>
+		/// Copy up to max samples beginning at cursor and advance it.
+		/// Samples overwritten before being read are skipped and counted in lost.
+		/// </summary>
+		size_t ReadSince(uint64_t& cursor, TimedSample* out, size_t max, uint64_t& lost) const
+		{
+			size_t count = 0;
+			while (count < max)
+			{
+				uint64_t head = head_.load(std::memory_order_acquire);
+				if (cursor >= head)
+					break;
+
+				// writer has lapped the reader
+				if (head - cursor > kCapacity)
+				{
+					lost += head - kCapacity - cursor;
+					cursor = head - kCapacity;
+				}
+
+				if (ReadSlot(cursor, out[count]))
+				{
+					count++;
+					cursor++;
+				}
+				else
+				{
+					// overwritten while reading, resync on next iteration
+					lost++;
+					cursor++;
+				}
+			}
+			return count;
+		}
+
+		// cursor which skips every sample received so far
+		uint64_t head() const { return head_.load(std::memory_order_acquire); }
+
+	private:
+		SampleHistory(const SampleHistory&) = delete;
+		SampleHistory(SampleHistory&&) = delete;
+		void operator= (const SampleHistory&) = delete;
+		void operator= (SampleHistory&&) = delete;
+
+		static_assert(std::is_trivially_copyable_v<TimedSample>);
+		static_assert(sizeof(TimedSample) % sizeof(uint32_t) == 0);
+		static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be power of 2.");
+
+		static constexpr size_t kMask = kCapacity - 1;
+		static constexpr size_t kWordCount = sizeof(TimedSample) / sizeof(uint32_t);
+
+		bool ReadSlot(uint64_t pos, TimedSample& out) const
+		{
+			const Slot& slot = slots_[pos & kMask];
+			uint64_t expected = pos * 2 + 2;
+			if (slot.stamp.load(std::memory_order_acquire) != expected)
+				return false;
+
+			uint32_t words[kWordCount];
+			for (size_t i = 0; i < kWordCount; i++)
+				words[i] = slot.words[i].load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.stamp.load(std::memory_order_relaxed) != expected)
+				return false;
+
+			std::memcpy(&out, words, sizeof(TimedSample));
+			return true;
+		}
+
+		struct Slot
+		{
+			std::atomic_uint64_t stamp;		// 2 * position + 2 when the slot holds a complete sample
+			std::atomic_uint32_t words[kWordCount];
+		};
+
+		alignas(kCacheLineSize) std::atomic_uint64_t head_;
+		alignas(kCacheLineSize) Slot slots_[kCapacity];
+	};
+
+}	// namespace dkvr
\ No newline at end of file
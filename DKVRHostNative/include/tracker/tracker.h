@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+
 #include "tracker/tracker_configuration.h"
 #include "tracker/tracker_data.h"
+#include "tracker/sample_history.h"
 #include "tracker/tracker_netstat.h"
 #include "tracker/tracker_statistic.h"
 #include "tracker/tracker_status.h"
@@ -23,12 +27,14 @@ namespace dkvr {
 
     public:
         Tracker(unsigned long address) :
-            address_(address), name_("unnamed tracker"), connection_(ConnectionStatus::Disconnected),
+            address_(address), name_("unnamed tracker"), connection_(ConnectionStatus::Disconnected), protocol_version_(1),
             netstat_{},
+            counters_(),
             status_{},
             statistic_{},
             config_{},
-            data_{}
+            data_(),
+            history_()
         {
             config_.Reset();
         }
@@ -36,10 +42,11 @@ namespace dkvr {
         void Reset()
         {
             connection_ = ConnectionStatus::Disconnected;
+            protocol_version_ = 1;
             netstat_ = TrackerNetworkStatistics{ 0, 0, };
             status_ = TrackerStatus{};
             statistic_ = TrackerStatistic{};
-            data_ = TrackerData{};
+            data_.Reset();
             config_.InvalidateAll();
             ResetRequestIndicator();
         }
@@ -60,6 +67,10 @@ namespace dkvr {
         void SetHandshaked()    { connection_ = ConnectionStatus::Handshaked; }
         void SetConnected()     { connection_ = ConnectionStatus::Connected; }
 
+        // protocol version negotiated on handshake
+        uint8_t protocol_version() const                { return protocol_version_; }
+        void set_protocol_version(uint8_t version)      { protocol_version_ = version; }
+
         // network statistics
         uint32_t send_sequence_num()        { return netstat_.send_sequence_num++; }
         uint32_t recv_sequence_num() const  { return netstat_.recv_sequence_num; }
@@ -70,15 +81,24 @@ namespace dkvr {
 
         void set_recv_sequence_num(uint32_t seq){ netstat_.recv_sequence_num = seq; }
         void UpdateHeartbeatSent()  { netstat_.last_heartbeat_sent = std::chrono::steady_clock::now(); }
-        void UpdateHeartbeatRecv()  { netstat_.last_heartbeat_recv = std::chrono::steady_clock::now(); }
         void UpdatePingSent()       { netstat_.last_ping_sent = std::chrono::steady_clock::now(); }
-        void UpdateRtt()
+
+        // received is the receive timestamp of the datagram, so queueing delay on the host is not counted
+        void UpdateHeartbeatRecv(int64_t received)  { netstat_.last_heartbeat_recv = SteadyTimePoint(received); }
+        void UpdateRtt(int64_t received)
         {
             using namespace std::chrono;
-            nanoseconds rtt = steady_clock::now() - netstat_.last_ping_sent;
-            netstat_.rtt = duration_cast<milliseconds>(rtt);
+            nanoseconds rtt = SteadyTimePoint(received) - netstat_.last_ping_sent;
+            netstat_.rtt = duration_cast<milliseconds>(std::max(rtt, nanoseconds::zero()));
         }
 
+        // network counters, lock-free and kept over Reset()
+        TrackerNetworkCounters network_counters() const    { return counters_.Load(); }
+        void CountReceived(size_t bytes)                    { counters_.CountReceived(bytes); }
+        void CountSent(size_t bytes)                        { counters_.CountSent(bytes); }
+        void CountLateDiscard()                             { counters_.CountLateDiscard(); }
+        void CountSequenceGap(uint32_t received)            { counters_.CountSequenceGap(netstat_.recv_sequence_num, received); }
+
         // tracker status
         uint8_t init_result() const  { return status_.init_result; }
         uint8_t battery_perc() const { return status_.battery_level; }
@@ -121,6 +141,8 @@ namespace dkvr {
         bool IsMagTransformSynced() const  { return config_.IsValid(ConfigurationKey::MagTransform); }
         bool IsNoiseVarianceSynced() const { return config_.IsValid(ConfigurationKey::NoiseVariance); }
         std::vector<ConfigurationKey> GetEveryUnsynced() const { return config_.GetEveryInvalid(); }
+        uint32_t unsynced_mask() const                         { return config_.GetInvalidMask(); }
+        uint32_t config_revision(ConfigurationKey key) const   { return config_.revision(key); }
 
         void SetBehaviorSynced()        { config_.Validate(ConfigurationKey::Behavior); }
         void SetGyrTransformSynced()    { config_.Validate(ConfigurationKey::GyrTransform); }
@@ -128,9 +150,10 @@ namespace dkvr {
         void SetMagTransformSynced()    { config_.Validate(ConfigurationKey::MagTransform); }
         void SetNoiseVarianceSynced()   { config_.Validate(ConfigurationKey::NoiseVariance); }
 
-        // tracker data
-        const RawDataSet& raw_data() const          { return data_.raw(); }
-        const NominalDataSet& nominal_data() const  { return data_.nominal(); }
+        // tracker data, getters are wait-free and may be called without the tracker lock
+        RawDataSet raw_data() const                 { return data_.raw(); }
+        NominalDataSet nominal_data() const         { return data_.nominal(); }
+        TrackerSample sample() const                { return data_.sample(); }
         Vector3f raw_gyro() const                   { return data_.raw().gyr; }
         Vector3f raw_accel() const                  { return data_.raw().acc; }
         Vector3f raw_mag() const                    { return data_.raw().mag; }
@@ -138,11 +161,25 @@ namespace dkvr {
         Vector3f linear_acceleration() const        { return data_.nominal().linear_acceleration; }
         Vector3f magnetic_disturbance() const       { return data_.nominal().magnetic_disturbance; }
 
-        bool IsRawDataUpdated()     { return data_.IsRawUpdated(); }
-        bool IsNominalDataUpdated() { return data_.IsNominalUpdated(); }
-        
-        void set_raw_data(RawDataSet raw)             { data_.set_raw(raw); }
-        void set_nominal_data(NominalDataSet nominal) { data_.set_nominal(nominal); }
+        // timestamp is the receive time of the datagram, or the time sample was taken for samples of a batched frame
+        void set_raw_data(RawDataSet raw, uint32_t sequence, int64_t timestamp)
+        {
+            TimedSample sample{ .timestamp = timestamp, .sequence = sequence, .kind = SampleKind::Raw };
+            sample.raw = raw;
+            data_.set_raw(raw, sample.timestamp);
+            history_.Push(sample);
+        }
+
+        void set_nominal_data(NominalDataSet nominal, uint32_t sequence, int64_t timestamp)
+        {
+            TimedSample sample{ .timestamp = timestamp, .sequence = sequence, .kind = SampleKind::Nominal };
+            sample.nominal = nominal;
+            data_.set_nominal(nominal, sample.timestamp);
+            history_.Push(sample);
+        }
+
+        // sample history survives Reset(), so cursors of consumers remain valid over reconnection
+        const SampleHistory& history() const { return history_; }
 
 
     // misc request indicator
@@ -172,13 +209,16 @@ namespace dkvr {
     private:
         unsigned long address_;
         std::string name_;
-        ConnectionStatus connection_;
+        std::atomic<ConnectionStatus> connection_;     // readable without the tracker lock
+        uint8_t protocol_version_;
 
         TrackerNetworkStatistics netstat_;
+        AtomicNetworkCounters counters_;
         TrackerStatus status_;
         TrackerStatistic statistic_;
         TrackerConfiguration config_;
         TrackerData data_;
+        SampleHistory history_;
     };
 
 }	// namespace dkvr
\ No newline at end of file
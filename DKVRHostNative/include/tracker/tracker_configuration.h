@@ -96,6 +96,13 @@ namespace dkvr {
                 if (!validated_[i]) result.push_back(ConfigurationKey(i));
             return result;
         }
+        uint32_t GetInvalidMask() const
+        {
+            uint32_t result = 0;
+            for (int i = 0; i < static_cast<int>(ConfigurationKey::Size); i++)
+                if (!validated_[i]) result |= 1u << i;
+            return result;
+        }
         bool IsValid(ConfigurationKey key) const { return validated_[static_cast<int>(key)]; }
         bool IsAllValid() const {
             for (bool b : validated_) 
@@ -103,9 +110,12 @@ namespace dkvr {
             return true;
         }
 
+        // bumped on every invalidation, tells a retransmission of the same value from a new one
+        uint32_t revision(ConfigurationKey key) const { return revision_[static_cast<int>(key)]; }
+
         void Validate(ConfigurationKey key) { validated_[static_cast<int>(key)] = true; }
-        void Invalidate(ConfigurationKey key) { validated_[static_cast<int>(key)] = false; }
-        void InvalidateAll() { for (bool& b : validated_) b = false; }
+        void Invalidate(ConfigurationKey key) { validated_[static_cast<int>(key)] = false; revision_[static_cast<int>(key)]++; }
+        void InvalidateAll() { for (int i = 0; i < static_cast<int>(ConfigurationKey::Size); i++) Invalidate(ConfigurationKey(i)); }
 
         void Reset() { behavior_.Reset(); calibration_.Reset(); }
 
@@ -133,6 +143,7 @@ namespace dkvr {
         TrackerBehavior behavior_;
         TrackerCalibration calibration_;
         bool validated_[static_cast<size_t>(ConfigurationKey::Size)];
+        uint32_t revision_[static_cast<size_t>(ConfigurationKey::Size)];
     };
 
     static_assert(std::is_trivial_v<TrackerCalibration>);
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <type_traits>
 
+#include "util/seqlock.h"
+
 namespace dkvr {
 	
 	struct Vector3f
@@ -46,24 +50,70 @@ namespace dkvr {
 		Vector3f magnetic_disturbance;
 	};
 
-	class TrackerData
+	// steady_clock in nanoseconds, common time base of every sample timestamp
+	inline int64_t SteadyTimestampNow()
 	{
-	public:
-		bool IsRawUpdated() { bool temp = raw_updated_; raw_updated_ = false; return temp; }
-		bool IsNominalUpdated() { bool temp = nominal_updated_; nominal_updated_ = false; return temp; }
+		using namespace std::chrono;
+		return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	}
 
-		const RawDataSet& raw() const { return raw_; }
-		const NominalDataSet& nominal() const { return nominal_; }
+	inline std::chrono::steady_clock::time_point SteadyTimePoint(int64_t timestamp)
+	{
+		using namespace std::chrono;
+		return steady_clock::time_point(duration_cast<steady_clock::duration>(nanoseconds(timestamp)));
+	}
+
+	/// <summary>
+	/// Every data set of a tracker published at once, so readers never mix two different updates.
+	/// </summary>
+	struct TrackerSample
+	{
+		RawDataSet raw;
+		NominalDataSet nominal;
+		int64_t timestamp;	// host receive time of the latest data set, steady_clock nanoseconds
+	};
 
-		void set_raw(RawDataSet raw) { raw_ = raw; raw_updated_ = true; }
-		void set_nominal(NominalDataSet nominal) { nominal_ = nominal; nominal_updated_; }
+	/// <summary>
+	/// Latest data sets are published through seqlock, raw(), nominal() and sample() are wait-free and safe without the tracker lock.
+	/// Setters still require the tracker lock.
+	/// </summary>
+	class TrackerData
+	{
+	public:
+		TrackerData() : published_(), latest_{} { }
+
+		void Reset()
+		{
+			latest_ = TrackerSample{};
+			published_.Store(latest_);
+		}
+
+		RawDataSet raw() const { return published_.Load().raw; }
+		NominalDataSet nominal() const { return published_.Load().nominal; }
+		TrackerSample sample() const { return published_.Load(); }
+
+		void set_raw(RawDataSet raw, int64_t timestamp)
+		{
+			latest_.raw = raw;
+			latest_.timestamp = timestamp;
+			published_.Store(latest_);
+		}
+
+		void set_nominal(NominalDataSet nominal, int64_t timestamp)
+		{
+			latest_.nominal = nominal;
+			latest_.timestamp = timestamp;
+			published_.Store(latest_);
+		}
 
 	private:
-		RawDataSet raw_;
-		NominalDataSet nominal_;
+		TrackerData(const TrackerData&) = delete;
+		TrackerData(TrackerData&&) = delete;
+		void operator= (const TrackerData&) = delete;
+		void operator= (TrackerData&&) = delete;
 
-		bool raw_updated_;
-		bool nominal_updated_;
+		SeqLock<TrackerSample> published_;
+		TrackerSample latest_;		// writer side copy
 	};
 
 	static_assert(sizeof Vector3f == sizeof(float) * 3);
@@ -81,4 +131,6 @@ namespace dkvr {
 	static_assert(offsetof(NominalDataSet, NominalDataSet::linear_acceleration) == sizeof Quaternionf);
 	static_assert(offsetof(NominalDataSet, NominalDataSet::magnetic_disturbance) == sizeof Quaternionf + sizeof Vector3f);
 
+	static_assert(std::is_trivially_copyable_v<TrackerSample>);
+
 }	// namespace dkvr
\ No newline at end of file
@@ -11,7 +11,7 @@ namespace dkvr
 
 	struct TrackerDebug
 	{
-		static constexpr size_t kMessageLength = sizeof(Instruction::payload) - sizeof(uint32_t) - sizeof(uint8_t);
+		static constexpr size_t kMessageLength = kBasePayloadSize - sizeof(uint32_t) - sizeof(uint8_t);
 
 		uint32_t timestamp;
 		uint8_t dkvr_err;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 
 namespace dkvr {
@@ -15,4 +17,65 @@ namespace dkvr {
 		std::chrono::milliseconds rtt;
 	};
 
+	struct TrackerNetworkCounters
+	{
+		uint64_t rx_packets;		// datagrams handed to the tracker, late ones included
+		uint64_t rx_bytes;
+		uint64_t tx_packets;		// instructions placed to the sending queue
+		uint64_t tx_bytes;
+		uint64_t late_discards;		// sequence number older than the latest one handled
+		uint64_t sequence_gaps;		// datagrams inferred lost from jumps of the sequence number
+	};
+
+	// cumulative counters of a tracker, updated and read without the tracker lock
+	class AtomicNetworkCounters
+	{
+	public:
+		// jump of sequence number larger than this is a restart of the tracker rather than loss
+		static constexpr uint32_t kMaxSequenceGap = 1024;
+
+		void CountReceived(size_t bytes)
+		{
+			rx_packets_.fetch_add(1, std::memory_order_relaxed);
+			rx_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		void CountSent(size_t bytes)
+		{
+			tx_packets_.fetch_add(1, std::memory_order_relaxed);
+			tx_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		void CountLateDiscard() { late_discards_.fetch_add(1, std::memory_order_relaxed); }
+
+		// latest is the sequence number handled last, received is the one right after it
+		void CountSequenceGap(uint32_t latest, uint32_t received)
+		{
+			uint32_t lost = received - latest - 1;
+			if (received > latest && lost > 0 && lost <= kMaxSequenceGap)
+				sequence_gaps_.fetch_add(lost, std::memory_order_relaxed);
+		}
+
+		TrackerNetworkCounters Load() const
+		{
+			return TrackerNetworkCounters
+			{
+				.rx_packets = rx_packets_.load(std::memory_order_relaxed),
+				.rx_bytes = rx_bytes_.load(std::memory_order_relaxed),
+				.tx_packets = tx_packets_.load(std::memory_order_relaxed),
+				.tx_bytes = tx_bytes_.load(std::memory_order_relaxed),
+				.late_discards = late_discards_.load(std::memory_order_relaxed),
+				.sequence_gaps = sequence_gaps_.load(std::memory_order_relaxed)
+			};
+		}
+
+	private:
+		std::atomic_uint64_t rx_packets_ = 0;
+		std::atomic_uint64_t rx_bytes_ = 0;
+		std::atomic_uint64_t tx_packets_ = 0;
+		std::atomic_uint64_t tx_bytes_ = 0;
+		std::atomic_uint64_t late_discards_ = 0;
+		std::atomic_uint64_t sequence_gaps_ = 0;
+	};
+
 }	// namespace dkvr
\ No newline at end of file
@@ -1,45 +1,107 @@
 #pragma once
 
-#include <memory>
+#include <cstdint>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tracker/tracker.h"
 #include "tracker/atomic_tracker.h"
+#include "util/event_tracer.h"
 #include "util/logger.h"
+#include "util/ring_buffer.h"
+#include "util/slab_storage.h"
 
 namespace dkvr {
 
+	/// <summary>
+	/// Lock-free copy of a tracker, data sets are taken from one consistent sample.
+	/// </summary>
+	struct TrackerSnapshot
+	{
+		unsigned long address;
+		Tracker::ConnectionStatus connection;
+		TrackerSample sample;
+	};
+
 	class TrackerProvider
 	{
 	public:
-		TrackerProvider() : mutex_(), trackers_() { }
+		// indices are always below this
+		static constexpr size_t kMaxTrackers = 256;
+
+		TrackerProvider() : mutex_(), slots_(), address_index_(), name_mutex_(), name_index_(), names_() { }
 		~TrackerProvider();
 
-		AtomicTracker FindExistOrInsertNew(unsigned long address);
+		AtomicTracker FindExistOrInsertNew(unsigned long address, int* index = nullptr);
+		AtomicTracker FindByAddress(unsigned long address, int* index = nullptr);
 		AtomicTracker FindByIndex(int index);
 		ConstAtomicTracker FindByIndex(int index) const;
 		AtomicTracker FindByName(std::string name);
 		std::vector<AtomicTracker> GetAllTrackers();
 
+		/// <summary>
+		/// Wait-free access to the latest data set, takes neither provider lock nor tracker lock.
+		/// Returns false if index is out of range.
+		/// </summary>
+		bool LoadRawData(int index, RawDataSet& out) const;
+		bool LoadNominalData(int index, NominalDataSet& out) const;
+		bool LoadSnapshot(int index, TrackerSnapshot& out) const;
+		bool LoadNetworkCounters(int index, TrackerNetworkCounters& out) const;
+
+		/// <summary>
+		/// Wait-free bulk read of sample history, see SampleHistory::ReadSince().
+		/// Returns 0 if index is out of range.
+		/// </summary>
+		size_t ReadSamples(int index, uint64_t& cursor, TimedSample* out, size_t max, uint64_t& lost) const;
+		uint64_t GetSampleCursor(int index) const;
 
 		size_t GetCount() const;
 		size_t GetIndexOf(const Tracker* target);
 
+		/// <summary>
+		/// Keep the name index up to date, call this whenever the name of a tracker has been changed.
+		/// Only takes the name index lock, so it's safe to call while holding an AtomicTracker.
+		/// </summary>
+		void UpdateName(unsigned long address, const std::string& name);
+
 	private:
-		using TrackerMutexPair = std::pair<Tracker, std::shared_ptr<std::mutex>>;
+		// lock sits right before its tracker, slots never share a cache line
+		struct alignas(kCacheLineSize) TrackerSlot
+		{
+			TrackerSlot(unsigned long address) : mutex(), tracker(address) { }
+
+			mutable std::mutex mutex;
+			Tracker tracker;
+		};
+
+		// slots are never moved once constructed, new slab is allocated every kSlabSize trackers
+		static constexpr size_t kSlabSize = 16;
+		static constexpr size_t kMaxSlabs = kMaxTrackers / kSlabSize;
 
 		TrackerProvider(const TrackerProvider&) = delete;
 		TrackerProvider(TrackerProvider&&) = delete;
 		void operator= (const TrackerProvider&) = delete;
 		void operator= (TrackerProvider&&) = delete;
 
-		AtomicTracker InternalAddTracker(unsigned long address);
+		// caller must hold mutex_, returns nullptr if the storage is full
+		TrackerSlot* InternalAddTracker(unsigned long address);
+
+		// slot is resolved under mutex_ and locked after releasing it, slots never move so the pointer stays valid
+		static AtomicTracker Lock(TrackerSlot* slot) { return slot ? AtomicTracker(&slot->tracker, slot->mutex) : AtomicTracker(); }
 
 		mutable std::mutex mutex_;
-		std::vector<TrackerMutexPair> trackers_;
+		SlabStorage<TrackerSlot, kSlabSize, kMaxSlabs> slots_;
+		std::unordered_map<unsigned long, size_t> address_index_;	// address -> index of slots_
+
+		// name index has it's own lock, never acquire mutex_ or tracker lock while holding it
+		mutable std::mutex name_mutex_;
+		std::unordered_map<std::string, unsigned long> name_index_;	// name -> address, first registered wins
+		std::unordered_map<unsigned long, std::string> names_;		// address -> name
 
 		Logger& logger_ = Logger::GetInstance();
+		EventTracer& tracer_ = EventTracer::GetInstance();	// Find* spans include waiting for the tracker lock
 
 	};
 
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "util/ring_buffer.h"
+
+namespace dkvr
+{
+
+    /**
+     * @brief   Opt-in event tracing of host threads, dumped as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+     *          Every thread writes to its own ring of @c kEventsPerThread events, the oldest ones are overwritten.
+     *          While stopped, recording costs a relaxed load and a branch.
+     *          Event names must be string literals, only the pointer is kept.
+     *          Loops trace their blocking waits as "wait" spans apart from the work spans.
+     */
+    class EventTracer
+    {
+    public:
+        // threads traced at once, a slot and its ring are handed to the next thread once its owner exits
+        static constexpr size_t kMaxThreads = 64;
+        static constexpr size_t kEventsPerThread = 1 << 14;
+
+        static EventTracer& GetInstance();
+
+        static int64_t Now()
+        {
+            using namespace std::chrono;
+            return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        }
+
+        /**
+         * @brief   Name of the calling thread shown in the dump, may be called whether tracing or not.
+         */
+        static void SetThreadName(const std::string& name);
+
+        bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // events recorded before Start() are left out of the dump
+        void Start();
+        void Stop();
+
+        // span of [begin, end], both from Now()
+        void Complete(const char* name, int64_t begin, int64_t end)   { if (IsEnabled()) Record(Phase::Complete, name, begin, end - begin); }
+        void Counter(const char* name, int64_t value)                  { if (IsEnabled()) Record(Phase::Counter, name, Now(), value); }
+        void Instant(const char* name)                                 { if (IsEnabled()) Record(Phase::Instant, name, Now(), 0); }
+
+        /**
+         * @brief   Write every event since the last @c Start() as Chrome trace JSON, may be called while tracing.
+         *          Events overwritten during the dump are skipped.
+         * @return  false if the file cannot be written
+         */
+        bool Dump(const std::string& path) const;
+
+        // threads that found every slot taken, they are never traced
+        size_t UntracedThreads() const { return untraced_count_.load(std::memory_order_relaxed); }
+
+    private:
+        enum class Phase : char
+        {
+            Complete = 'X',
+            Counter = 'C',
+            Instant = 'i'
+        };
+
+        struct Event
+        {
+            int64_t timestamp;
+            int64_t value;          // duration of Complete, value of Counter
+            const char* name;
+            Phase phase;
+        };
+
+        // single writer, the owning thread
+        struct alignas(kCacheLineSize) ThreadEvents
+        {
+            std::atomic_uint64_t head = 0;
+            std::atomic_uint64_t first = 0;     // events below this belong to a previous owner of the slot
+            std::unique_ptr<Event[]> events;
+            std::string name;
+        };
+
+        // per-thread slot owner, returns the slot on thread exit
+        struct ThreadSlot
+        {
+            ThreadEvents* events = nullptr;
+            bool untraced = false;              // every slot was taken when this thread came
+
+            ~ThreadSlot();
+        };
+
+        EventTracer();
+        EventTracer(const EventTracer&) = delete;
+        EventTracer(EventTracer&&) = delete;
+        void operator= (const EventTracer&) = delete;
+        void operator= (EventTracer&&) = delete;
+
+        void Record(Phase phase, const char* name, int64_t timestamp, int64_t value);
+        ThreadEvents* AcquireThreadEvents();
+        void ReleaseThreadEvents(ThreadEvents* events);
+
+        static thread_local ThreadSlot thread_slot_;
+
+        std::atomic_bool enabled_;
+        std::atomic_int64_t start_;
+        std::unique_ptr<ThreadEvents[]> threads_;
+        std::atomic_size_t thread_count_;       // slots below this are fully set up
+        std::vector<size_t> free_slots_;        // slots of exited threads
+        std::atomic_size_t untraced_count_;
+        mutable std::mutex slot_mutex_;         // guards slot setup, free slots and thread names
+    };
+
+    /**
+     * @brief   Traces its own lifetime as a span, nothing is recorded if tracing was stopped on construction.
+     */
+    class TraceScope
+    {
+    public:
+        TraceScope(EventTracer& tracer, const char* name) :
+            tracer_(tracer), name_(name), begin_(tracer.IsEnabled() ? EventTracer::Now() : 0) { }
+        ~TraceScope() { if (begin_) tracer_.Complete(name_, begin_, EventTracer::Now()); }
+
+    private:
+        TraceScope(const TraceScope&) = delete;
+        void operator= (const TraceScope&) = delete;
+
+        EventTracer& tracer_;
+        const char* name_;
+        int64_t begin_;
+    };
+
+}   // namespace dkvr
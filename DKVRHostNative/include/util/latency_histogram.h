@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace dkvr
+{
+
+    /**
+     * @brief   Merged content of one or more @c LatencyHistogram, plain values safe to copy around.
+     */
+    struct LatencySnapshot
+    {
+        static constexpr int kSubBucketBits = 3;
+        static constexpr uint64_t kSubBuckets = 1ull << kSubBucketBits;
+        static constexpr int kMaxExponent = 40;     // values from 2^40 ns (about 18 minutes) fall into the last bucket
+        static constexpr size_t kBucketCount = kSubBuckets + (kMaxExponent - kSubBucketBits) * kSubBuckets;
+
+        uint64_t count;
+        int64_t sum;        // nanoseconds
+        int64_t min;
+        int64_t max;
+        uint64_t buckets[kBucketCount];
+
+        // values below kSubBuckets are exact, every power of two above is split into kSubBuckets linear buckets
+        static size_t BucketOf(uint64_t value)
+        {
+            if (value < kSubBuckets)
+                return static_cast<size_t>(value);
+
+            int exponent = std::bit_width(value) - 1;
+            if (exponent >= kMaxExponent)
+                return kBucketCount - 1;
+
+            int shift = exponent - kSubBucketBits;
+            uint64_t sub = (value >> shift) - kSubBuckets;
+            return static_cast<size_t>(kSubBuckets + shift * kSubBuckets + sub);
+        }
+
+        // highest value of the bucket
+        static int64_t BucketUpperBound(size_t bucket)
+        {
+            if (bucket < kSubBuckets)
+                return static_cast<int64_t>(bucket);
+
+            size_t shift = (bucket - kSubBuckets) / kSubBuckets;
+            uint64_t sub = (bucket - kSubBuckets) % kSubBuckets;
+            uint64_t lower = (kSubBuckets + sub) << shift;
+            return static_cast<int64_t>(lower + (1ull << shift) - 1);
+        }
+
+        int64_t mean() const { return count ? sum / static_cast<int64_t>(count) : 0; }
+
+        // smallest bucket bound with at least quantile of the values below or equal to it, never above max
+        int64_t Percentile(double quantile) const
+        {
+            if (count == 0)
+                return 0;
+
+            uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(count) + 0.5);
+            if (rank == 0) rank = 1;
+            if (rank > count) rank = count;
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBucketCount; i++)
+            {
+                seen += buckets[i];
+                if (seen >= rank)
+                {
+                    int64_t bound = BucketUpperBound(i);
+                    return bound < max ? bound : max;
+                }
+            }
+            return max;
+        }
+    };
+
+    /**
+     * @brief   Log-bucketed latency histogram in nanoseconds with relative precision of 1 / @c LatencySnapshot::kSubBuckets.
+     *          Recording is lock-free and wait-free except for a new minimum or maximum.
+     *          Intended to be written by one thread, so the buckets never bounce between cores, but concurrent writers are still safe.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static constexpr size_t kBucketCount = LatencySnapshot::kBucketCount;
+
+        LatencyHistogram() : buckets_{}, sum_(0), min_(std::numeric_limits<int64_t>::max()), max_(0) { }
+
+        void Record(int64_t nanoseconds, uint64_t count = 1)
+        {
+            // clocks of different threads may disagree by a few nanoseconds
+            if (nanoseconds < 0)
+                nanoseconds = 0;
+
+            buckets_[LatencySnapshot::BucketOf(static_cast<uint64_t>(nanoseconds))].fetch_add(count, std::memory_order_relaxed);
+            sum_.fetch_add(nanoseconds * static_cast<int64_t>(count), std::memory_order_relaxed);
+
+            int64_t current = min_.load(std::memory_order_relaxed);
+            while (nanoseconds < current && !min_.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed));
+            current = max_.load(std::memory_order_relaxed);
+            while (nanoseconds > current && !max_.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed));
+        }
+
+        // add the content to @a out, values recorded meanwhile may or may not be included
+        void MergeInto(LatencySnapshot& out) const
+        {
+            for (size_t i = 0; i < kBucketCount; i++)
+            {
+                uint64_t value = buckets_[i].load(std::memory_order_relaxed);
+                out.buckets[i] += value;
+                out.count += value;
+            }
+            out.sum += sum_.load(std::memory_order_relaxed);
+
+            int64_t min = min_.load(std::memory_order_relaxed);
+            int64_t max = max_.load(std::memory_order_relaxed);
+            if (min < out.min) out.min = min;
+            if (max > out.max) out.max = max;
+        }
+
+        void Reset()
+        {
+            for (std::atomic_uint64_t& bucket : buckets_)
+                bucket.store(0, std::memory_order_relaxed);
+            sum_.store(0, std::memory_order_relaxed);
+            min_.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        void operator= (const LatencyHistogram&) = delete;
+
+        std::atomic_uint64_t buckets_[kBucketCount];
+        std::atomic_int64_t sum_;
+        std::atomic_int64_t min_;
+        std::atomic_int64_t max_;
+    };
+
+}   // namespace dkvr
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "util/log_record.h"
+
+namespace dkvr {
+
+	/// <summary>
+	/// <para>Token bucket rate limiter for a single logging call site, each key (e.g. tracker address) has its own bucket.</para>
+	/// <para>Messages over the rate are not formatted at all, only the latest one is kept and counted.
+	/// The next admitted message reports how many were suppressed, and if the key goes quiet
+	/// the kept message is written by the logger with "last message repeated N times".</para>
+	/// <para>Registers itself to the logger for the lifetime of the object.</para>
+	/// </summary>
+	class LogRateLimiter
+	{
+	public:
+		static constexpr size_t kMaxKeys = 16;
+		// suppressed messages of a key idle for this long are written by the logger
+		static constexpr std::chrono::seconds kFoldInterval{ 1 };
+
+		LogRateLimiter(double rate_per_second = 1.0, double burst = 5.0);
+		~LogRateLimiter();
+
+		/// <summary>
+		/// Returns false if record must be suppressed. Otherwise record is marked with the suppressed count.
+		/// Least recently used key is evicted when every bucket is taken, suppressed count of it is lost.
+		/// </summary>
+		bool Admit(uint64_t key, LogRecord& record);
+
+		// collect the last suppressed messages of idle keys, returns the number of records written to out
+		size_t Sweep(int64_t now, LogRecord* out, size_t max);
+
+		static int64_t Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+	private:
+		LogRateLimiter(const LogRateLimiter&) = delete;
+		LogRateLimiter(LogRateLimiter&&) = delete;
+		void operator= (const LogRateLimiter&) = delete;
+		void operator= (LogRateLimiter&&) = delete;
+
+		struct Entry
+		{
+			bool used;
+			uint64_t key;
+			double tokens;
+			int64_t last_seen;			// steady_clock nanoseconds
+			uint32_t suppressed;
+			LogRecord last;				// latest suppressed message
+		};
+
+		Entry& FindOrEvict(uint64_t key, int64_t now);
+
+		std::mutex mutex_;
+		Entry entries_[kMaxKeys];
+		const double rate_;
+		const double burst_;
+	};
+
+}	// namespace dkvr
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "fmt/core.h"
+#include "fmt/format.h"
+
+namespace dkvr {
+
+	// how a record stands for messages folded by LogRateLimiter
+	enum class LogFold : uint8_t
+	{
+		None,
+		Suppressed,		// similar messages were suppressed before this one
+		Repeated		// this is the last of the suppressed messages
+	};
+
+	/// <summary>
+	/// <para>Compact, trivially copyable log record which is formatted later on the logger thread.</para>
+	/// <para>Format string must outlive the record, which always holds for fmt::format_string literals.
+	/// Arguments are copied by value into the payload, strings are truncated to fit the remaining space.</para>
+	/// </summary>
+	struct LogRecord
+	{
+		using FormatFunc = void(*)(const LogRecord& record, fmt::memory_buffer& out);
+
+		static constexpr size_t kPayloadSize = 216;
+
+		FormatFunc format;				// format id, decodes the payload with the types of the call site
+		const char* format_string;
+		uint32_t format_size;
+		uint8_t level;
+		uint8_t prefixed;				// 0 for raw strings pushed by operator<<
+		LogFold fold;
+		uint32_t repeated;				// number of folded messages
+		int64_t timestamp;				// system_clock nanoseconds
+		unsigned char payload[kPayloadSize];
+	};
+
+	/// <summary>
+	/// Packs arguments into LogRecord::payload and formats them back.
+	/// Fixed-size arguments are placed first in order, strings follow as (uint16 length, bytes).
+	/// </summary>
+	template<typename... Args>
+	class LogRecordCodec
+	{
+		template<typename T>
+		static constexpr bool kIsString =
+			std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+			std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>;
+
+		template<typename T>
+		using Stored = std::conditional_t<kIsString<T>, std::string_view, T>;
+
+		template<typename T>
+		static constexpr size_t kFixedSizeOf = kIsString<T> ? 0 : sizeof(T);
+
+		static constexpr size_t kFixedSize = (size_t(0) + ... + kFixedSizeOf<Args>);
+
+		static_assert(kFixedSize <= LogRecord::kPayloadSize, "Too many log arguments.");
+		static_assert((... && (kIsString<Args> || std::is_trivially_copyable_v<Args>)), "Log argument must be string or trivially copyable.");
+
+		struct Cursor
+		{
+			size_t fixed;
+			size_t string;
+		};
+
+	public:
+		static void Pack(LogRecord& record, const Args&... args)
+		{
+			[[maybe_unused]] Cursor cursor{ 0, kFixedSize };	// untouched without arguments
+			(Write(record, cursor, args), ...);
+			record.format = &Format;
+		}
+
+		static void Format(const LogRecord& record, fmt::memory_buffer& out)
+		{
+			[[maybe_unused]] Cursor cursor{ 0, kFixedSize };
+			// braced initialization evaluates in order
+			std::tuple<Stored<Args>...> values{ Read<Args>(record, cursor)... };
+			fmt::string_view fmt(record.format_string, record.format_size);
+			std::apply([&](auto&... v) { fmt::vformat_to(fmt::appender(out), fmt, fmt::make_format_args(v...)); }, values);
+		}
+
+	private:
+		template<typename T>
+		static std::string_view ToStringView(const T& arg)
+		{
+			if constexpr (std::is_array_v<T>)
+				return std::string_view(arg, strnlen(arg, std::extent_v<T>));
+			else if constexpr (std::is_pointer_v<T>)
+				return arg ? std::string_view(arg) : std::string_view("(null)");
+			else
+				return std::string_view(arg);
+		}
+
+		template<typename T>
+		static void Write(LogRecord& record, Cursor& cursor, const T& arg)
+		{
+			if constexpr (kIsString<T>)
+			{
+				if (LogRecord::kPayloadSize - cursor.string < sizeof(uint16_t))
+					return;
+
+				std::string_view str = ToStringView(arg);
+				uint16_t length = static_cast<uint16_t>(std::min(str.size(), LogRecord::kPayloadSize - cursor.string - sizeof(uint16_t)));
+				std::memcpy(record.payload + cursor.string, &length, sizeof(uint16_t));
+				std::memcpy(record.payload + cursor.string + sizeof(uint16_t), str.data(), length);
+				cursor.string += sizeof(uint16_t) + length;
+			}
+			else
+			{
+				std::memcpy(record.payload + cursor.fixed, &arg, sizeof(T));
+				cursor.fixed += sizeof(T);
+			}
+		}
+
+		template<typename T>
+		static Stored<T> Read(const LogRecord& record, Cursor& cursor)
+		{
+			if constexpr (kIsString<T>)
+			{
+				if (LogRecord::kPayloadSize - cursor.string < sizeof(uint16_t))
+					return std::string_view();
+
+				uint16_t length;
+				std::memcpy(&length, record.payload + cursor.string, sizeof(uint16_t));
+				const char* data = reinterpret_cast<const char*>(record.payload + cursor.string + sizeof(uint16_t));
+				cursor.string += sizeof(uint16_t) + length;
+				return std::string_view(data, length);
+			}
+			else
+			{
+				T value;
+				std::memcpy(&value, record.payload + cursor.fixed, sizeof(T));
+				cursor.fixed += sizeof(T);
+				return value;
+			}
+		}
+	};
+
+}	// namespace dkvr
\ No newline at end of file
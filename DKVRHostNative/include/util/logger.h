@@ -1,16 +1,24 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <ctime>
 #include <list>
 #include <mutex>
 #include <ostream>
-#include <queue>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "fmt/chrono.h"
 #include "fmt/core.h"
+#include "util/log_rate_limiter.h"
+#include "util/log_record.h"
+#include "util/message_arena.h"
+#include "util/ring_buffer.h"
+#include "util/thread_container.h"
 
 #ifndef DKVR_LOGGER_GLOBAL_LEVEL
 #	define DKVR_LOGGER_GLOBAL_LEVEL	2
@@ -26,7 +34,11 @@
 namespace dkvr {
 
 	/// <summary>
-	/// Some stupid logging class for internal usage.
+	/// <para>Some stupid logging class for internal usage.</para>
+	/// <para>While the formatter thread is running, Error/Info/Debug only copy the arguments into a LogRecord
+	/// and push it to a lock-free ring, formatting and writing are done in batches on the formatter thread.
+	/// Records are dropped (and reported later) rather than blocking the caller when the ring is full.
+	/// Otherwise logs are formatted and written synchronously.</para>
 	/// </summary>
 	class Logger
 	{
@@ -39,7 +51,7 @@ namespace dkvr {
 
 		__pragma(dkvr_export) enum class Mode {
 			Echo,	// print logs to the console immediately
-			Burst,	// hold logs ultil explicitly call PrintUnchecked()
+			Burst,	// hold logs ultil explicitly call PrintUnchecked(), oldest ones are overwritten when the buffer is full
 			Silent	// all logs will automatically checked (ignored)
 		};
 
@@ -55,24 +67,48 @@ namespace dkvr {
 		template<typename... Args>
 		void Debug(const fmt::format_string<Args...> fmt, Args&&... args);
 
+		// rate-limited variants for per-packet paths, key distinguishes the source within the call site
+		template<typename... Args>
+		void Error(LogRateLimiter& limiter, uint64_t key, const fmt::format_string<Args...> fmt, Args&&... args);
+		template<typename... Args>
+		void Info(LogRateLimiter& limiter, uint64_t key, const fmt::format_string<Args...> fmt, Args&&... args);
+		template<typename... Args>
+		void Debug(LogRateLimiter& limiter, uint64_t key, const fmt::format_string<Args...> fmt, Args&&... args);
+
 		int GetUncheckedCount() const;
 		void PrintUnchecked();
 		void PrintUnchecked(std::size_t count);
 
-		Logger& operator<< (std::string&& str) { Push(std::move(str)); return *this; }
-		Logger& operator<< (const std::string& str) { Push(str); return *this; }
+		/// <summary>
+		/// Formatter thread is reference counted, each StartFormatter() must be paired with StopFormatter().
+		/// The last StopFormatter() joins the thread and writes the remaining records synchronously.
+		/// </summary>
+		void StartFormatter();
+		void StopFormatter();
+
+		// block until records pushed before the call are written, no-op if the formatter is not running
+		void Flush() const;
+
+		// raw line without prefix, a line longer than a record holds (kMaxRawRecordSize) is written synchronously after Flush()
+		Logger& operator<< (const std::string& str);
 		Logger& operator<< (Level level) { set_level(level); return *this; }
 		Logger& operator<< (Mode mode) { set_mode(mode); return *this; }
 
 		std::ostream& ostream() const { return *out_; }
 		Level level() const { return level_; }
 		Mode mode() const { return mode_; }
+		// logs dropped by the formatter ring plus unchecked logs overwritten in Burst mode
+		uint64_t dropped() const;
 
-		void set_ostream(std::ostream& ostream) { out_ = &ostream; }
+		void set_ostream(std::ostream& ostream);
+		// bytes of unchecked log buffer, current unchecked logs are discarded
+		void set_unchecked_capacity(size_t capacity);
 		void set_level(Level level) { level_ = level; }
 		void set_mode(Mode mode) { mode_ = mode; }
 
 	private:
+		friend class LogRateLimiter;
+
 		Logger();
 		Logger(const Logger&) = delete;
 		Logger(Logger&&) = delete;
@@ -80,14 +116,71 @@ namespace dkvr {
 		void operator= (const Logger&) = delete;
 		void operator= (Logger&&) = delete;
 
-		void Push(std::string&& str);
-		void Push(const std::string& str);
+		static constexpr size_t kRingCapacity = 1024;
+		static constexpr size_t kMaxRawRecordSize = LogRecord::kPayloadSize - sizeof(uint16_t);
+		static constexpr size_t kDefaultUncheckedCapacity = 256 * 1024;
+		static constexpr size_t kFormatBatchSize = 64;
+		static constexpr std::chrono::milliseconds kFormatterIdleWait{ 5 };
+		static constexpr std::chrono::milliseconds kLimiterSweepInterval{ 500 };
+
+		// formatted "%Y-%m-%d %H:%M:%S" is reused while the second stays the same
+		struct TimeCache
+		{
+			int64_t second = -1;
+			char text[32] = {};
+			size_t size = 0;
+		};
+
+		template<typename... Args>
+		static void Pack(LogRecord& record, Level level, bool prefixed, fmt::string_view fmt, const Args&... args);
+		template<typename... Args>
+		void Enqueue(Level level, bool prefixed, fmt::string_view fmt, const Args&... args);
+		template<typename... Args>
+		void EnqueueLimited(LogRateLimiter& limiter, uint64_t key, Level level, fmt::string_view fmt, const Args&... args);
+		void Submit(const LogRecord& record);
+
+		void RegisterLimiter(LogRateLimiter* limiter);
+		void UnregisterLimiter(LogRateLimiter* limiter);
+		void SweepLimiters();
+
+		void FormatterLoop();
+		size_t Drain(size_t max);
+		void NotifyProcessed() const;
+		void ReportDropped(fmt::memory_buffer& buffer, std::vector<size_t>& ends);
+		void Write(const fmt::memory_buffer& buffer, std::span<const size_t> ends);
+
+		static void FormatRecord(const LogRecord& record, fmt::memory_buffer& out, TimeCache& cache);
+		static void FormatPrefix(Level level, int64_t timestamp, fmt::memory_buffer& out, TimeCache& cache);
 
 		mutable std::mutex mutex_;
-		std::queue<std::string> unchecked_;
+		MessageArena unchecked_;
 		std::ostream* out_;
-		Level level_;
-		Mode mode_;
+		std::atomic<Level> level_;
+		std::atomic<Mode> mode_;
+
+		// formatter
+		RingBuffer<LogRecord, kRingCapacity, OverflowPolicy::DropNewest> ring_;
+		ThreadContainer<Logger> formatter_;
+		std::mutex formatter_mutex_;
+		int formatter_refs_;
+		std::atomic_bool formatter_active_;
+		std::atomic_int submitting_;		// producers between reading formatter_active_ and pushing
+		std::atomic_uint64_t submitted_;
+		std::atomic_uint64_t processed_;
+		mutable std::mutex idle_mutex_;
+		mutable std::condition_variable idle_cv_;
+		mutable std::mutex processed_mutex_;
+		mutable std::condition_variable processed_cv_;	// Flush() waits here, notified when processed_ advances or the formatter stops
+
+		std::mutex limiters_mutex_;
+		std::vector<LogRateLimiter*> limiters_;
+
+		// accessed by formatter thread only
+		fmt::memory_buffer batch_buffer_;
+		std::vector<size_t> batch_ends_;
+		TimeCache time_cache_;
+		uint64_t reported_dropped_;
+		int64_t last_sweep_;
 	};
 
 	template<typename... Args>
@@ -99,20 +192,16 @@ namespace dkvr {
 	template<typename... Args>
 	inline void Logger::Error(const fmt::format_string<Args...> fmt, Args&&... args)
 	{
-		if (level_ >= Level::Error) {
-			std::string msg = fmt::vformat(fmt.get(), fmt::make_format_args(args...));
-			Push(fmt::format("[ERROR] {:%Y-%m-%d %H:%M:%S}\t{}", fmt::localtime(std::time(nullptr)), msg));
-		}
+		if (level_ >= Level::Error)
+			Enqueue(Level::Error, true, fmt.get(), args...);
 	}
 
 	template<typename... Args>
 	inline void Logger::Info(const fmt::format_string<Args...> fmt, Args&&... args)
 	{
 #ifndef DKVR_LOGGER_SUPPRESS_INFO
-		if (level_ >= Level::Info) {
-			std::string msg = fmt::vformat(fmt.get(), fmt::make_format_args(args...));
-			Push(fmt::format("[INFO] {:%Y-%m-%d %H:%M:%S}\t{}", fmt::localtime(std::time(nullptr)), msg));
-		}
+		if (level_ >= Level::Info)
+			Enqueue(Level::Info, true, fmt.get(), args...);
 #endif
 	}
 
@@ -120,11 +209,71 @@ namespace dkvr {
 	inline void Logger::Debug(const fmt::format_string<Args...> fmt, Args&&... args)
 	{
 #ifndef DKVR_LOGGER_SUPPRESS_DEBUG
-		if (level_ >= Level::Debug) {
-			std::string msg = fmt::vformat(fmt.get(), fmt::make_format_args(args...));
-			Push(fmt::format("[DEBUG] {:%Y-%m-%d %H:%M:%S}\t{}", fmt::localtime(std::time(nullptr)), msg));
-		}
+		if (level_ >= Level::Debug)
+			Enqueue(Level::Debug, true, fmt.get(), args...);
 #endif
 	}
 
+	template<typename... Args>
+	inline void Logger::Error(LogRateLimiter& limiter, uint64_t key, const fmt::format_string<Args...> fmt, Args&&... args)
+	{
+		if (level_ >= Level::Error)
+			EnqueueLimited(limiter, key, Level::Error, fmt.get(), args...);
+	}
+
+	template<typename... Args>
+	inline void Logger::Info(LogRateLimiter& limiter, uint64_t key, const fmt::format_string<Args...> fmt, Args&&... args)
+	{
+#ifndef DKVR_LOGGER_SUPPRESS_INFO
+		if (level_ >= Level::Info)
+			EnqueueLimited(limiter, key, Level::Info, fmt.get(), args...);
+#endif
+	}
+
+	template<typename... Args>
+	inline void Logger::Debug(LogRateLimiter& limiter, uint64_t key, const fmt::format_string<Args...> fmt, Args&&... args)
+	{
+#ifndef DKVR_LOGGER_SUPPRESS_DEBUG
+		if (level_ >= Level::Debug)
+			EnqueueLimited(limiter, key, Level::Debug, fmt.get(), args...);
+#endif
+	}
+
+	template<typename... Args>
+	inline void Logger::Pack(LogRecord& record, Level level, bool prefixed, fmt::string_view fmt, const Args&... args)
+	{
+		record.format_string = fmt.data();
+		record.format_size = static_cast<uint32_t>(fmt.size());
+		record.level = static_cast<uint8_t>(level);
+		record.prefixed = prefixed;
+		record.fold = LogFold::None;
+		record.repeated = 0;
+		record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		LogRecordCodec<std::remove_cvref_t<Args>...>::Pack(record, args...);
+	}
+
+	template<typename... Args>
+	inline void Logger::Enqueue(Level level, bool prefixed, fmt::string_view fmt, const Args&... args)
+	{
+		if (mode_ == Mode::Silent)
+			return;
+
+		LogRecord record;
+		Pack(record, level, prefixed, fmt, args...);
+		Submit(record);
+	}
+
+	template<typename... Args>
+	inline void Logger::EnqueueLimited(LogRateLimiter& limiter, uint64_t key, Level level, fmt::string_view fmt, const Args&... args)
+	{
+		if (mode_ == Mode::Silent)
+			return;
+
+		// packing is a few copies, formatting is deferred until admitted
+		LogRecord record;
+		Pack(record, level, true, fmt, args...);
+		if (limiter.Admit(key, record))
+			Submit(record);
+	}
+
 }	// namespace dkvr
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace dkvr
+{
+
+    /**
+     * @brief   Preallocated byte ring holding variable-length messages in FIFO order.
+     *          Each message is stored as (uint32 length, bytes) and may wrap around the end of the buffer.
+     *          When there is no room, the oldest messages are overwritten and counted as dropped.
+     *          Memory is allocated only by the constructor and @c Reset(), not synchronized.
+     */
+    class MessageArena
+    {
+    public:
+        static constexpr size_t kMinCapacity = 1024;
+
+        explicit MessageArena(size_t capacity) { Reset(capacity); }
+
+        // discards every message, dropped count is kept
+        void Reset(size_t capacity)
+        {
+            capacity_ = std::max(capacity, kMinCapacity);
+            buffer_ = std::make_unique<char[]>(capacity_);
+            head_ = 0;
+            tail_ = 0;
+            count_ = 0;
+        }
+
+        /**
+         * @brief   Append @a message, truncated if it does not fit in the whole arena.
+         */
+        void Push(std::string_view message)
+        {
+            uint32_t length = static_cast<uint32_t>(std::min(message.size(), capacity_ - kHeaderSize));
+            size_t required = kHeaderSize + length;
+            while (capacity_ - static_cast<size_t>(tail_ - head_) < required)
+            {
+                Pop();
+                dropped_++;
+            }
+
+            CopyIn(tail_, &length, kHeaderSize);
+            CopyIn(tail_ + kHeaderSize, message.data(), length);
+            tail_ += required;
+            count_++;
+        }
+
+        /**
+         * @brief   Oldest message, split into @a first and @a second if it wraps around.
+         * @return  false if empty
+         */
+        bool Front(std::string_view& first, std::string_view& second) const
+        {
+            if (count_ == 0)
+                return false;
+
+            uint32_t length;
+            CopyOut(head_, &length, kHeaderSize);
+
+            size_t offset = static_cast<size_t>((head_ + kHeaderSize) % capacity_);
+            size_t first_length = std::min<size_t>(length, capacity_ - offset);
+            first = std::string_view(buffer_.get() + offset, first_length);
+            second = std::string_view(buffer_.get(), length - first_length);
+            return true;
+        }
+
+        void Pop()
+        {
+            if (count_ == 0)
+                return;
+
+            uint32_t length;
+            CopyOut(head_, &length, kHeaderSize);
+            head_ += kHeaderSize + length;
+            count_--;
+        }
+
+        size_t size() const { return count_; }
+        size_t capacity() const { return capacity_; }
+        uint64_t dropped() const { return dropped_; }
+
+    private:
+        static constexpr size_t kHeaderSize = sizeof(uint32_t);
+
+        void CopyIn(uint64_t pos, const void* src, size_t size)
+        {
+            size_t offset = static_cast<size_t>(pos % capacity_);
+            size_t first = std::min(size, capacity_ - offset);
+            std::memcpy(buffer_.get() + offset, src, first);
+            std::memcpy(buffer_.get(), static_cast<const char*>(src) + first, size - first);
+        }
+
+        void CopyOut(uint64_t pos, void* dst, size_t size) const
+        {
+            size_t offset = static_cast<size_t>(pos % capacity_);
+            size_t first = std::min(size, capacity_ - offset);
+            std::memcpy(dst, buffer_.get() + offset, first);
+            std::memcpy(static_cast<char*>(dst) + first, buffer_.get(), size - first);
+        }
+
+        std::unique_ptr<char[]> buffer_;
+        size_t capacity_ = 0;
+        uint64_t head_ = 0;         // absolute position of the oldest message
+        uint64_t tail_ = 0;         // absolute position to write the next message
+        size_t count_ = 0;
+        uint64_t dropped_ = 0;
+    };
+
+}   // namespace dkvr
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "util/latency_histogram.h"
+#include "util/ring_buffer.h"
+
+namespace dkvr
+{
+
+    // stages of a received datagram, each one measured from the end of the previous stage
+    enum class LatencyStage
+    {
+        KernelToReceive,    // kernel receive timestamp until the network thread handles it (Linux only)
+        ReceiveToQueue,     // network thread until the datagram is placed to the receiving queue
+        QueueToPop,         // waiting in the receiving queue until a dispatcher worker pops it
+        PopToDispatch,      // popped until the dispatcher starts handling it
+        DispatchToLock,     // tracker lookup until the tracker lock is acquired
+        LockToPublish,      // handling the instruction under the tracker lock
+        KernelToPublish,    // whole pipeline, recorded only for instructions which published samples
+        Count
+    };
+
+    /**
+     * @brief   Latency histograms of every @c LatencyStage of one host instance.
+     *          Each role of the receive pipeline (the network thread, every dispatcher shard) records to its own histograms,
+     *          they are merged only when read. A role is run by one thread at a time, so restarted threads reuse the same slot.
+     */
+    class PipelineLatency
+    {
+    public:
+        static constexpr size_t kStageCount = static_cast<size_t>(LatencyStage::Count);
+        static constexpr size_t kMaxDispatchers = 16;
+        static constexpr size_t kRecorderCount = 1 + kMaxDispatchers;
+
+        // recorder of each role
+        static constexpr size_t kNetworkRecorder = 0;
+        static constexpr size_t DispatcherRecorder(size_t shard) { return 1 + shard; }
+
+        PipelineLatency();
+
+        void Record(size_t recorder, LatencyStage stage, int64_t nanoseconds, uint64_t count = 1)
+        {
+            recorders_[recorder].stages[static_cast<size_t>(stage)].Record(nanoseconds, count);
+        }
+
+        LatencySnapshot Snapshot(LatencyStage stage) const;
+        void Reset();
+
+    private:
+        PipelineLatency(const PipelineLatency&) = delete;
+        PipelineLatency(PipelineLatency&&) = delete;
+        void operator= (const PipelineLatency&) = delete;
+        void operator= (PipelineLatency&&) = delete;
+
+        struct alignas(kCacheLineSize) RecorderHistograms
+        {
+            LatencyHistogram stages[kStageCount];
+        };
+
+        std::unique_ptr<RecorderHistograms[]> recorders_;
+    };
+
+}   // namespace dkvr
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace dkvr
+{
+
+    inline constexpr size_t kCacheLineSize = 64;
+
+    enum class OverflowPolicy
+    {
+        DropNewest,     // reject the element being pushed
+        DropOldest      // discard the front element to make room
+    };
+
+    /**
+     * @brief   Fixed-capacity lock-free ring buffer.
+     *          Every slot carries a sequence number, so producers and consumers only contend on their own index.
+     *          Safe for multiple producers and multiple consumers, producers race each other on a CAS of the enqueue index.
+     *          With @c OverflowPolicy::DropOldest a producer pops the front itself, so it also races the consumers
+     *          and may retry while one of them is in the middle of a pop. Use @c SpscRingBuffer for a single producer and consumer.
+     *          Elements dropped by overflow are counted.
+     */
+    template<typename T, size_t Capacity, OverflowPolicy Policy>
+    class RingBuffer
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be power of 2.");
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        static constexpr size_t kCapacity = Capacity;
+
+        RingBuffer()
+        {
+            for (size_t i = 0; i < Capacity; i++)
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief   Push @a item, overflow is resolved by @c Policy.
+         * @return  false if @a item itself was dropped (only with @c OverflowPolicy::DropNewest)
+         */
+        bool Push(const T& item)
+        {
+            while (!TryPush(item))
+            {
+                if constexpr (Policy == OverflowPolicy::DropNewest)
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                {
+                    T discarded;
+                    if (TryPop(discarded))
+                        dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            return true;
+        }
+
+        bool TryPush(const T& item)
+        {
+            Slot* slot;
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                slot = &slots_[pos & kMask];
+                size_t seq = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;   // full
+                }
+                else
+                {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            slot->data = item;
+            slot->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool TryPop(T& out)
+        {
+            Slot* slot;
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                slot = &slots_[pos & kMask];
+                size_t seq = slot->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;   // empty
+                }
+                else
+                {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            out = slot->data;
+            slot->sequence.store(pos + Capacity, std::memory_order_release);
+            return true;
+        }
+
+        // true if front element is not published yet
+        bool Empty() const
+        {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            return slots_[pos & kMask].sequence.load(std::memory_order_acquire) != pos + 1;
+        }
+
+        // approximate under concurrent access
+        size_t Size() const
+        {
+            size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+            size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr size_t kMask = Capacity - 1;
+
+        struct Slot
+        {
+            std::atomic_size_t sequence;
+            T data;
+        };
+
+        alignas(kCacheLineSize) std::atomic_size_t enqueue_pos_ = 0;
+        alignas(kCacheLineSize) std::atomic_size_t dequeue_pos_ = 0;
+        alignas(kCacheLineSize) std::atomic_uint64_t dropped_ = 0;
+        alignas(kCacheLineSize) Slot slots_[Capacity];
+    };
+
+}   // namespace dkvr
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include "util/ring_buffer.h"
+
+namespace dkvr
+{
+
+    /**
+     * @brief   Single-writer sequence lock publishing the latest value of @c T.
+     *          @c Store() never waits, @c Load() retries only while a store is in progress and never blocks the writer.
+     *          Payload is kept as relaxed atomic words so torn reads are detected instead of being undefined.
+     *          Stores must be serialized by the caller (e.g. under the tracker lock).
+     */
+    template<typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(sizeof(T) % sizeof(uint32_t) == 0, "T must be a multiple of 4 bytes.");
+
+    public:
+        SeqLock() : sequence_(0), words_{} { }
+
+        void Store(const T& value)
+        {
+            uint32_t buffer[kWordCount];
+            std::memcpy(buffer, &value, sizeof(T));
+
+            uint64_t seq = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < kWordCount; i++)
+                words_[i].store(buffer[i], std::memory_order_relaxed);
+
+            sequence_.store(seq + 2, std::memory_order_release);
+        }
+
+        T Load() const
+        {
+            uint32_t buffer[kWordCount];
+            while (true)
+            {
+                uint64_t before = sequence_.load(std::memory_order_acquire);
+                if (before & 1)
+                {
+                    std::this_thread::yield();  // writer is in the middle of Store()
+                    continue;
+                }
+
+                for (size_t i = 0; i < kWordCount; i++)
+                    buffer[i] = words_[i].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) == before)
+                    break;
+            }
+
+            T value;
+            std::memcpy(&value, buffer, sizeof(T));
+            return value;
+        }
+
+        // number of completed stores
+        uint64_t version() const { return sequence_.load(std::memory_order_acquire) >> 1; }
+
+    private:
+        SeqLock(const SeqLock&) = delete;
+        SeqLock(SeqLock&&) = delete;
+        void operator= (const SeqLock&) = delete;
+        void operator= (SeqLock&&) = delete;
+
+        static constexpr size_t kWordCount = sizeof(T) / sizeof(uint32_t);
+
+        alignas(kCacheLineSize) std::atomic_uint64_t sequence_;
+        std::atomic_uint32_t words_[kWordCount];
+    };
+
+}   // namespace dkvr
\ No newline at end of file
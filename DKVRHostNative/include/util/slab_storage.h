@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace dkvr
+{
+
+    /**
+     * @brief   Append-only container with stable element address.
+     *          Elements are constructed in place inside fixed-size slabs, growing the container allocates a new slab
+     *          and never moves nor touches the existing elements.
+     *          @c Emplace() must be serialized by the caller, but @c size() and the elements below it
+     *          can be read concurrently without any lock since slab table never reallocates.
+     */
+    template<typename T, size_t SlabSize, size_t MaxSlabs>
+    class SlabStorage
+    {
+    public:
+        static constexpr size_t kCapacity = SlabSize * MaxSlabs;
+
+        SlabStorage() : slabs_(), size_(0) { }
+        ~SlabStorage() { Clear(); }
+
+        // precondition : !Full()
+        template<typename... Args>
+        T& Emplace(Args&&... args)
+        {
+            size_t index = size_.load(std::memory_order_relaxed);
+            if (index % SlabSize == 0 && !slabs_[index / SlabSize])
+                slabs_[index / SlabSize] = std::make_unique<Slab>();
+
+            T* ptr = new (Address(index)) T(std::forward<Args>(args)...);
+            size_.store(index + 1, std::memory_order_release);    // publish after construction
+            return *ptr;
+        }
+
+        void Clear()
+        {
+            for (size_t i = size(); i > 0; i--)
+                (*this)[i - 1].~T();
+            for (std::unique_ptr<Slab>& slab : slabs_)
+                slab.reset();
+            size_.store(0, std::memory_order_relaxed);
+        }
+
+        T& operator[] (size_t index)             { return *std::launder(reinterpret_cast<T*>(Address(index))); }
+        const T& operator[] (size_t index) const { return *std::launder(reinterpret_cast<const T*>(Address(index))); }
+
+        size_t size() const { return size_.load(std::memory_order_acquire); }
+        bool Full() const   { return size() == kCapacity; }
+
+    private:
+        SlabStorage(const SlabStorage&) = delete;
+        SlabStorage(SlabStorage&&) = delete;
+        void operator= (const SlabStorage&) = delete;
+        void operator= (SlabStorage&&) = delete;
+
+        struct Slab
+        {
+            alignas(T) unsigned char storage[sizeof(T) * SlabSize];
+        };
+
+        void* Address(size_t index) const
+        {
+            return slabs_[index / SlabSize]->storage + sizeof(T) * (index % SlabSize);
+        }
+
+        std::unique_ptr<Slab> slabs_[MaxSlabs];
+        std::atomic_size_t size_;
+    };
+
+}   // namespace dkvr
\ No newline at end of file
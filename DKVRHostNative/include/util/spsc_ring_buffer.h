@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "util/ring_buffer.h"
+
+namespace dkvr
+{
+
+    /**
+     * @brief   Fixed-capacity single producer, single consumer ring buffer which keeps the newest elements.
+     *          Producer never looks at the consumer, it overwrites the oldest slot when the ring is full.
+     *          Every slot is a sequence lock, consumer skips the slots overwritten before or while it reads them
+     *          and counts them as dropped. Neither side retries on the other, there is no CAS.
+     *          Payload is kept as relaxed atomic words so torn reads are detected instead of being undefined.
+     */
+    template<typename T, size_t Capacity>
+    class SpscRingBuffer
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be power of 2.");
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(sizeof(T) % sizeof(uint32_t) == 0, "T must be a multiple of 4 bytes.");
+
+    public:
+        static constexpr size_t kCapacity = Capacity;
+
+        SpscRingBuffer() = default;
+
+        // producer only, never fails
+        void Push(const T& item)
+        {
+            uint32_t buffer[kWordCount];
+            std::memcpy(buffer, &item, sizeof(T));
+
+            uint64_t pos = tail_.load(std::memory_order_relaxed);
+            Slot& slot = slots_[pos & kMask];
+            slot.sequence.store(2 * pos + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < kWordCount; i++)
+                slot.words[i].store(buffer[i], std::memory_order_relaxed);
+
+            slot.sequence.store(2 * pos + 2, std::memory_order_release);
+            tail_.store(pos + 1, std::memory_order_release);
+        }
+
+        // consumer only
+        bool TryPop(T& out)
+        {
+            uint32_t buffer[kWordCount];
+            uint64_t pos = head_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                uint64_t tail = tail_.load(std::memory_order_acquire);
+                if (pos == tail)
+                {
+                    head_.store(pos, std::memory_order_relaxed);
+                    return false;
+                }
+
+                // whole laps overwritten since the last pop
+                if (tail - pos > Capacity)
+                {
+                    dropped_.fetch_add(tail - Capacity - pos, std::memory_order_relaxed);
+                    pos = tail - Capacity;
+                }
+
+                const Slot& slot = slots_[pos & kMask];
+                uint64_t expected = 2 * pos + 2;
+                if (slot.sequence.load(std::memory_order_acquire) == expected)
+                {
+                    for (size_t i = 0; i < kWordCount; i++)
+                        buffer[i] = slot.words[i].load(std::memory_order_relaxed);
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (slot.sequence.load(std::memory_order_relaxed) == expected)
+                        break;
+                }
+
+                // producer has started the next lap on this slot, the element is gone
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                pos++;
+            }
+
+            head_.store(pos + 1, std::memory_order_relaxed);
+            std::memcpy(&out, buffer, sizeof(T));
+            return true;
+        }
+
+        // consumer only, elements being overwritten still count
+        bool Empty() const
+        {
+            return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+        }
+
+        // approximate when called by neither side
+        size_t Size() const
+        {
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+            uint64_t size = tail > head ? tail - head : 0;
+            return static_cast<size_t>(size < Capacity ? size : Capacity);
+        }
+
+        // counted by the consumer when it skips them
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        SpscRingBuffer(const SpscRingBuffer&) = delete;
+        SpscRingBuffer(SpscRingBuffer&&) = delete;
+        void operator= (const SpscRingBuffer&) = delete;
+        void operator= (SpscRingBuffer&&) = delete;
+
+        static constexpr size_t kMask = Capacity - 1;
+        static constexpr size_t kWordCount = sizeof(T) / sizeof(uint32_t);
+
+        // sequence is 2 * position + 1 while being written, 2 * position + 2 once published
+        struct Slot
+        {
+            std::atomic_uint64_t sequence = 0;
+            std::atomic_uint32_t words[kWordCount] = {};
+        };
+
+        alignas(kCacheLineSize) std::atomic_uint64_t tail_ = 0;     // written by producer
+        alignas(kCacheLineSize) std::atomic_uint64_t head_ = 0;     // written by consumer
+        alignas(kCacheLineSize) std::atomic_uint64_t dropped_ = 0;
+        alignas(kCacheLineSize) Slot slots_[Capacity];
+    };
+
+}   // namespace dkvr
@@ -2,20 +2,24 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
 #include <thread>
 
+#include "util/event_tracer.h"
+
 namespace dkvr
 {
 
     /**
      * @brief   Controller class for infinite looping thread.
      *          @c Run() will begin the thread that keep calling @c callback_.
+     *          Named container gives its name to the thread in @c EventTracer dumps.
      */
     template<typename T>
     class ThreadContainer
     {
     public:
-        ThreadContainer(const T& caller) : caller_(caller) { }
+        ThreadContainer(const T& caller, std::string name = "") : caller_(caller), name_(std::move(name)) { }
         virtual ~ThreadContainer() { Stop(); }
 
         void Run()
@@ -42,6 +46,9 @@ namespace dkvr
             thread_running_ = false;
         }
 
+        // let the thread exit after the current call, Stop() joins it
+        void RequestStop() { exit_flag_ = true; }
+
         void StopAsync()
         {
             if (!thread_running_) return;
@@ -67,6 +74,9 @@ namespace dkvr
 
         void ThreadLoop()
         {
+            if (!name_.empty())
+                EventTracer::SetThreadName(name_);
+
             while (!exit_flag_)
                 (const_cast<T&>(caller_).*callback_)();
 
@@ -79,6 +89,7 @@ namespace dkvr
 
         void (T::* callback_)() = nullptr;
         const T& caller_;
+        const std::string name_;
     };
 
 }   // namespace dkvr
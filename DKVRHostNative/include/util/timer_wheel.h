@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace dkvr
+{
+
+    /**
+     * @brief   Hierarchical timer wheel with 1ms tick and 4 levels of 64 slots (about 4.6 hours of range).
+     *          Timers are intrusive, the owner keeps them alive and the wheel never allocates.
+     *          Level 0 holds timers due within 64 ticks at exact tick, upper levels cascade down on their boundary.
+     *          Every operation is O(1) except @c Advance() which is O(elapsed ticks + due timers).
+     *          Not synchronized, used by a single thread.
+     */
+    class TimerWheel
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr Clock::duration kTick = std::chrono::milliseconds(1);
+        static constexpr size_t kLevels = 4;
+        static constexpr size_t kSlotBits = 6;
+        static constexpr size_t kSlots = size_t(1) << kSlotBits;
+
+        struct Timer
+        {
+            Timer* prev = nullptr;
+            Timer* next = nullptr;
+            uint64_t expiry = 0;        // tick
+            uint32_t id = 0;            // free for the owner
+            uint16_t level = 0;
+            uint16_t index = 0;
+            bool armed = false;
+        };
+
+        explicit TimerWheel(Clock::time_point origin = Clock::now()) : origin_(origin), current_(0), occupied_{}, slots_{} { }
+
+        /**
+         * @brief   Arm @a timer to expire at or after @a deadline, rearms if already armed.
+         *          Deadline in the past expires on the next @c Advance().
+         */
+        void Schedule(Timer& timer, Clock::time_point deadline)
+        {
+            if (timer.armed)
+                Unlink(timer);
+
+            timer.expiry = std::max(TickCeil(deadline), current_);
+            timer.armed = true;
+            Link(timer);
+        }
+
+        void Cancel(Timer& timer)
+        {
+            if (timer.armed)
+                Unlink(timer);
+            timer.armed = false;
+        }
+
+        /**
+         * @brief   Expire every timer due at @a now, @a callback(Timer&) is called with the timer disarmed.
+         *          Callback may schedule the timer again (including the same one).
+         */
+        template<typename F>
+        void Advance(Clock::time_point now, F&& callback)
+        {
+            uint64_t target = TickFloor(now);
+            while (current_ <= target)
+            {
+                if (Empty())
+                {
+                    current_ = target + 1;
+                    break;
+                }
+
+                if ((current_ & kMask) == 0)
+                    Cascade(1);
+
+                size_t index = current_ & kMask;
+                Timer* timer = slots_[0][index];
+                slots_[0][index] = nullptr;
+                occupied_[0] &= ~(uint64_t(1) << index);
+                current_++;
+
+                while (timer)
+                {
+                    Timer* next = timer->next;
+                    timer->prev = timer->next = nullptr;
+                    if (timer->expiry >= current_)
+                    {
+                        // clamped to the range of the wheel
+                        Link(*timer);
+                    }
+                    else
+                    {
+                        timer->armed = false;
+                        callback(*timer);
+                    }
+                    timer = next;
+                }
+            }
+        }
+
+        /**
+         * @brief   Earliest time @c Advance() has something to do, either expire or cascade.
+         *          @c Clock::time_point::max() if no timer is armed.
+         */
+        Clock::time_point NextDeadline() const
+        {
+            if (Empty())
+                return Clock::time_point::max();
+
+            uint64_t next = UINT64_MAX;
+            for (size_t level = 0; level < kLevels; level++)
+            {
+                if (occupied_[level] == 0)
+                    continue;
+
+                size_t shift = level * kSlotBits;
+                uint64_t base = current_ >> shift;
+                size_t index = base & kMask;
+                // current slot of upper level is already cascaded unless current_ sits right on its boundary
+                size_t offset = (level == 0 || (current_ & ((uint64_t(1) << shift) - 1)) == 0) ? 0 : 1;
+                uint64_t rotated = std::rotr(occupied_[level], static_cast<int>((index + offset) & kMask));
+                uint64_t distance = std::countr_zero(rotated) + offset;
+                next = std::min(next, (base + distance) << shift);
+            }
+            return origin_ + next * kTick;
+        }
+
+        bool Empty() const
+        {
+            for (uint64_t bits : occupied_)
+                if (bits) return false;
+            return true;
+        }
+
+    private:
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel(TimerWheel&&) = delete;
+        void operator=(const TimerWheel&) = delete;
+        void operator=(TimerWheel&&) = delete;
+
+        static constexpr uint64_t kMask = kSlots - 1;
+        static constexpr uint64_t kRange = uint64_t(1) << (kSlotBits * kLevels);
+
+        uint64_t TickFloor(Clock::time_point time) const
+        {
+            if (time <= origin_) return 0;
+            return static_cast<uint64_t>((time - origin_) / kTick);
+        }
+
+        uint64_t TickCeil(Clock::time_point time) const
+        {
+            if (time <= origin_) return 0;
+            if (time == Clock::time_point::max()) return UINT64_MAX;
+            Clock::duration elapsed = time - origin_;
+            return static_cast<uint64_t>((elapsed + kTick - Clock::duration(1)) / kTick);
+        }
+
+        void Link(Timer& timer)
+        {
+            uint64_t delta = timer.expiry - current_;
+            if (delta >= kRange)
+                delta = kRange - 1;
+
+            size_t level = 0;
+            while (level + 1 < kLevels && delta >= (uint64_t(1) << (kSlotBits * (level + 1))))
+                level++;
+
+            uint64_t slot_tick = current_ + delta;
+            size_t index = (slot_tick >> (level * kSlotBits)) & kMask;
+
+            Timer*& head = slots_[level][index];
+            timer.level = static_cast<uint16_t>(level);
+            timer.index = static_cast<uint16_t>(index);
+            timer.prev = nullptr;
+            timer.next = head;
+            if (head)
+                head->prev = &timer;
+            head = &timer;
+            occupied_[level] |= uint64_t(1) << index;
+        }
+
+        void Unlink(Timer& timer)
+        {
+            if (timer.prev)
+            {
+                timer.prev->next = timer.next;
+            }
+            else
+            {
+                slots_[timer.level][timer.index] = timer.next;
+                if (timer.next == nullptr)
+                    occupied_[timer.level] &= ~(uint64_t(1) << timer.index);
+            }
+            if (timer.next)
+                timer.next->prev = timer.prev;
+            timer.prev = timer.next = nullptr;
+        }
+
+        // move the slot of level reached by current_ down to lower levels
+        void Cascade(size_t level)
+        {
+            if (level >= kLevels)
+                return;
+
+            uint64_t base = current_ >> (level * kSlotBits);
+            size_t index = base & kMask;
+            if (index == 0)
+                Cascade(level + 1);
+
+            Timer* timer = slots_[level][index];
+            slots_[level][index] = nullptr;
+            occupied_[level] &= ~(uint64_t(1) << index);
+            while (timer)
+            {
+                Timer* next = timer->next;
+                Link(*timer);
+                timer = next;
+            }
+        }
+
+        Clock::time_point origin_;
+        uint64_t current_;                      // next tick to be processed
+        uint64_t occupied_[kLevels];            // non-empty slot bitmap
+        Timer* slots_[kLevels][kSlots];
+    };
+
+}   // namespace dkvr
\ No newline at end of file
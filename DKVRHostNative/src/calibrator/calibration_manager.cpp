@@ -21,6 +21,8 @@ namespace dkvr
 		constexpr size_t kRequiredStaticSampleSize = 100;
 		constexpr size_t kRequiredRotationalSampleSize = 1000;
 		constexpr std::chrono::milliseconds kValidationInterval(500);
+		constexpr std::chrono::milliseconds kSamplePollInterval(10);
+		constexpr size_t kSampleBatchSize = 64;
 
 		const std::string kStringIdle = "Idle";
 		const std::string kStringConfiguring = "Configuring";
@@ -114,8 +116,11 @@ namespace dkvr
 			if (target_index_ != -1)
 			{
 				AtomicTracker target = tk_provider_.FindByIndex(target_index_);
-				target->set_behavior(saved_behavior_);
-				target->set_calibration(saved_calibration_);
+				if (target)
+				{
+					target->set_behavior(saved_behavior_);
+					target->set_calibration(saved_calibration_);
+				}
 			}
 
 			logger_.Info("Calibration process aborted.");
@@ -212,6 +217,7 @@ namespace dkvr
 			.noise_variance = { 0, 0, 0,   0, 0, 0,   0, 0, 0 }
 		};
 
+		EventTracer::SetThreadName("calibration configuring");
 		status_ = CalibratorStatus::Configuring;
 
 		// configure target
@@ -242,52 +248,56 @@ namespace dkvr
 
 	void CalibrationManager::RecordingThreadLoop()
 	{
+		EventTracer::SetThreadName("calibration recording");
 		status_ = CalibratorStatus::Recording;
 		progress_perc_ = 0;
 
-		// begin sample record
+		// begin sample record, read from the sample history so nothing is missed between polls
 		samples_.clear();
-		while (!exit_flag_)
+		uint64_t cursor = tk_provider_.GetSampleCursor(target_index_);
+		uint64_t lost = 0;
+		TimedSample batch[kSampleBatchSize];
+		bool recorded = false;
+		while (!exit_flag_ && !recorded)
 		{
-			// get IMU readings if updated
-			bool yield = false;
-			RawDataSet data;
+			size_t count = tk_provider_.ReadSamples(target_index_, cursor, batch, kSampleBatchSize, lost);
+			tracer_.Counter("calibration samples", static_cast<int64_t>(samples_.size()));
+			if (count == 0)
 			{
-				AtomicTracker target = tk_provider_.FindByIndex(target_index_);
-				if (target->IsRawDataUpdated())
-					data = target->raw_data();
-				else
-					yield = true;
-			}	// tracker should be released before yielding thread
-
-			if (yield)
-			{
-				std::this_thread::yield();
+				std::this_thread::sleep_for(kSamplePollInterval);
 				continue;
 			}
 
-			// handle by sample type
-			if (sample_type_ == SampleType::Rotational)
+			for (size_t i = 0; i < count && !recorded; i++)
 			{
-				samples_.push_back(data);
+				if (batch[i].kind != SampleKind::Raw)
+					continue;
 
-				progress_perc_ = static_cast<int>((samples_.size() * 100.0 / kRequiredRotationalSampleSize));
-				if (samples_.size() >= kRequiredRotationalSampleSize)
-					break;
-			}
-			else
-			{
-				if (samples_.empty() || IsStaticConstraintSatisfied(data, samples_.back()))
+				// handle by sample type
+				const RawDataSet& data = batch[i].raw;
+				if (sample_type_ == SampleType::Rotational)
 				{
 					samples_.push_back(data);
 
-					progress_perc_ = static_cast<int>((samples_.size() * 100.0 / kRequiredStaticSampleSize));
-					if (samples_.size() >= kRequiredStaticSampleSize)
-						break;
+					progress_perc_ = static_cast<int>((samples_.size() * 100.0 / kRequiredRotationalSampleSize));
+					recorded = samples_.size() >= kRequiredRotationalSampleSize;
+				}
+				else
+				{
+					if (samples_.empty() || IsStaticConstraintSatisfied(data, samples_.back()))
+					{
+						samples_.push_back(data);
+
+						progress_perc_ = static_cast<int>((samples_.size() * 100.0 / kRequiredStaticSampleSize));
+						recorded = samples_.size() >= kRequiredStaticSampleSize;
+					}
 				}
 			}
 		}
 
+		if (lost)
+			logger_.Debug("[Calibration] {} samples lost while recording.", lost);
+
 		// aborted
 		if (exit_flag_)	
 			return;
@@ -313,6 +323,7 @@ namespace dkvr
 
 	void CalibrationManager::HandleSamples()
 	{
+		TraceScope scope(tracer_, "HandleSamples");
 		gyro_calibrator_.Accumulate(sample_type_, samples_);
 		accel_calibrator_.Accumulate(sample_type_, samples_);
 		mag_calibrator_.Accumulate(sample_type_, samples_);
@@ -320,6 +331,7 @@ namespace dkvr
 
 	void CalibrationManager::ApplyCalibration()
 	{
+		TraceScope scope(tracer_, "ApplyCalibration");
 		progress_perc_ = 0;
 
 		// calculate accel first (cuz it's the fastest)
@@ -1,73 +1,133 @@
 #include "controller/instruction_dispatcher.h"
 
+#include <cstdint>
+#include <memory>
+
 #include "instruction/instruction_set.h"
+#include "tracker/tracker_data.h"
 
 namespace dkvr {
 
-	InstructionDispatcher::InstructionDispatcher(NetworkService& net_service, TrackerProvider& tk_provider): 
-		inst_handler_(),
-		dispatcher_thread_(*this),
+	InstructionDispatcher::InstructionDispatcher(NetworkService& net_service, TrackerProvider& tk_provider, SampleNotifier& notifier, TrackerUpdater& updater, PipelineLatency& latency): 
+		inst_handler_(tk_provider),
+		workers_(),
 		net_service_(net_service), 
-		tk_provider_(tk_provider) 
+		tk_provider_(tk_provider),
+		notifier_(notifier),
+		updater_(updater),
+		latency_(latency)
 	{ 
-		dispatcher_thread_ += &InstructionDispatcher::WaitReceiveAndDispatch;
+		static_assert(PipelineLatency::kMaxDispatchers >= UDPServer::kMaxReceiveShards);
+		for (size_t shard = 0; shard < net_service_.receive_shard_count(); shard++)
+			workers_.push_back(std::make_unique<Worker>(*this, shard));
 	}
 
 	void InstructionDispatcher::Run()
 	{
-		dispatcher_thread_.Run();
-		logger_.Debug("Dispatcher thread launched.");
+		for (std::unique_ptr<Worker>& worker : workers_)
+			worker->thread().Run();
+		logger_.Debug("Dispatcher thread launched ({} workers).", workers_.size());
 
 	}
 
 	void InstructionDispatcher::Stop()
 	{
-        // because WaitAndPopReceived needs wakeup,
-        // asynchronously call Stop() and send wakeup signal
-		dispatcher_thread_.StopAsync();
-        net_service_.RequestWakeup();
-		while (dispatcher_thread_.IsRunning());	// just spin lock cuz there's nothing to do
+        // because WaitAndPopReceived needs wakeup, raise the exit flags first and send one wakeup signal
+        // a worker parking after the signal returns at once, the request is kept until it waits
+		for (std::unique_ptr<Worker>& worker : workers_)
+			worker->thread().RequestStop();
+		net_service_.RequestWakeup();
+
+		for (std::unique_ptr<Worker>& worker : workers_)
+			worker->thread().Stop();
         logger_.Debug("Dispatcher thread closed.");
 	}
 
-	void InstructionDispatcher::WaitReceiveAndDispatch()
+	void InstructionDispatcher::WaitReceiveAndDispatch(size_t shard)
 	{
 		unsigned long address;
 		Instruction inst;
-		if (net_service_.WaitAndPopReceived(address, inst))
-			Dispatch(address, inst);
+		DatagramTimestamp timestamp;
+		bool received;
+		{
+			TraceScope scope(tracer_, "wait");
+			received = net_service_.WaitAndPopReceived(address, inst, timestamp, shard);
+		}
+		if (received)
+			Dispatch(shard, address, inst, timestamp);
 	}
 
-	void InstructionDispatcher::Dispatch(unsigned long address, Instruction& inst)
+	void InstructionDispatcher::Dispatch(size_t shard, unsigned long address, Instruction& inst, const DatagramTimestamp& timestamp)
 	{
+		TraceScope scope(tracer_, "Dispatch");
+		size_t recorder = PipelineLatency::DispatcherRecorder(shard);
+		int64_t dispatched = SteadyTimestampNow();
+		latency_.Record(recorder, LatencyStage::QueueToPop, timestamp.popped - timestamp.queued);
+		latency_.Record(recorder, LatencyStage::PopToDispatch, dispatched - timestamp.popped);
+
 		unsigned char* ip = reinterpret_cast<unsigned char*>(&address);
 
-		// check opener value
-		if (inst.opener != kOpenerValue) 
-		{
-			logger_.Error("Wrong header value({:X}) from {:d}.{:d}.{:d}.{:d}", inst.opener, ip[0], ip[1], ip[2], ip[3]);
-			return;
-		}
+		// header is validated by the network service at receive time
 
-		// discard late datagram
-		AtomicTracker target = tk_provider_.FindExistOrInsertNew(address);
-		if (target->recv_sequence_num() > inst.sequence) 
+		int index = -1;
+		uint64_t history_begin, history_end;
+		bool connection_changed, config_acked;
 		{
-			logger_.Debug(
-				"Late datagram discarded from {:d}.{:d}.{:d}.{:d}, current : {} / recieved : {}",
-				ip[0], ip[1], ip[2], ip[3],
-				target->recv_sequence_num(),
-				inst.sequence
-			);
-			return;
-		}
+			// only handshake may allocate a tracker, anything else from unknown sender is discarded
+			AtomicTracker target = (Opcode(inst.opcode) == Opcode::Handshake1) ?
+				tk_provider_.FindExistOrInsertNew(address, &index) :
+				tk_provider_.FindByAddress(address, &index);
+			if (!target)
+				return;		// unknown sender or tracker storage is full
+
+			int64_t locked = SteadyTimestampNow();
+			latency_.Record(recorder, LatencyStage::DispatchToLock, locked - dispatched);
+			target->CountReceived(kInstructionHeaderSize + inst.length);
+
+			// discard late datagram
+			if (target->recv_sequence_num() > inst.sequence) 
+			{
+				target->CountLateDiscard();
+				logger_.Debug(
+					late_log_limit_, address,
+					"Late datagram discarded from {:d}.{:d}.{:d}.{:d}, current : {} / recieved : {}",
+					ip[0], ip[1], ip[2], ip[3],
+					target->recv_sequence_num(),
+					inst.sequence
+				);
+				return;
+			}
+
+			// delegate to controller
+			Tracker::ConnectionStatus connection = target->connection_status();
+			uint32_t unsynced = target->unsynced_mask();
+			history_begin = target->history().head();
+			{
+				TraceScope handle_scope(tracer_, "Handle");
+				inst_handler_.Handle(target, inst, timestamp.received);
+			}
+			history_end = target->history().head();
+
+			int64_t published = SteadyTimestampNow();
+			latency_.Record(recorder, LatencyStage::LockToPublish, published - locked);
+			if (history_end != history_begin)
+				latency_.Record(recorder, LatencyStage::KernelToPublish, published - timestamp.received);
+
+			connection_changed = target->connection_status() != connection;
+			config_acked = (unsynced & ~target->unsynced_mask()) != 0;
 
-		// delegate to controller
-		inst_handler_.Handle(target, inst);
+			// update recv_sequence only on connected status, gaps are meaningful only if it was connected before
+			if (target->IsConnected())
+			{
+				if (connection == Tracker::ConnectionStatus::Connected)
+					target->CountSequenceGap(inst.sequence);
+				target->set_recv_sequence_num(inst.sequence);
+			}
+		}	// tracker must be released before notifying, consumers may access it
 
-		// update recv_sequence only on connected status
-		if (target->IsConnected())
-			target->set_recv_sequence_num(inst.sequence);
+		notifier_.Notify(index, history_begin, history_end);
+		if (connection_changed || config_acked)
+			updater_.RequestUpdate(index);
 	}
 
 }	// namespace dkvr
\ No newline at end of file
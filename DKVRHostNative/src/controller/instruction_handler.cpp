@@ -1,5 +1,12 @@
 #include "controller/instruction_handler.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "instruction/compact_nominal.h"
 #include "instruction/instruction_set.h"
 
 #include "tracker/tracker.h"
@@ -15,88 +22,133 @@ namespace dkvr
     {
         constexpr uint8_t kCalibTransformSize = sizeof TrackerCalibration::gyr_transform;
         constexpr uint8_t kCalibNoiseVarSize = sizeof TrackerCalibration::noise_variance;
-    }
 
-    void InstructionHandler::Handle(Tracker* target, Instruction& inst)
-    {
-        switch (Opcode(inst.opcode))
+        // returns false without calling back if count disagrees with the payload length
+        template <typename T, typename F>
+        bool ForEachBatchedSample(const Instruction& inst, F&& callback)
         {
-            // network
-        case Opcode::Handshake1:
-            Handshake1(target, inst); break;
-
-        case Opcode::Handshake2:
-            Handshake2(target, inst); break;
-
-        case Opcode::Heartbeat:
-            Heartbeat(target, inst); break;
-
-        case Opcode::Ping:
-            Ping(target, inst); break;
-
-        case Opcode::Pong:
-            Pong(target, inst); break;
-
-            // miscellanous
-        case Opcode::Locate:
-            Locate(target, inst); break;
-
-        case Opcode::ClientName:
-            ClientName(target, inst); break;
-
-            // configuration
-        case Opcode::Behavior:
-            Behavior(target, inst); break;
-
-        case Opcode::GyrTransform:
-            GyrTransform(target, inst); break;
-
-        case Opcode::AccTransform:
-            AccTransform(target, inst); break;
-
-        case Opcode::MagTransform:
-            MagTransform(target, inst); break;
-
-        case Opcode::NoiseVariance:
-            NoiseVariance(target, inst); break;
-
-
-            // data transfer
-        case Opcode::Status:
-            Status(target, inst); break;
-
-        case Opcode::Raw:
-            Raw(target, inst); break;
-
-        case Opcode::Nominal:
-            Nominal(target, inst); break;
+            const uint8_t* payload = reinterpret_cast<const uint8_t*>(inst.payload);
+            SampleBatchHeader header;
+            memcpy(&header, payload, sizeof header);
+            if (header.count == 0 || header.count > kMaxBatchSamples<T> ||
+                sizeof header + header.count * sizeof(BatchedSample<T>) > inst.length)
+                return false;
+
+            const uint8_t* ptr = payload + sizeof header;
+            for (uint32_t i = 0; i < header.count; i++, ptr += sizeof(BatchedSample<T>))
+            {
+                BatchedSample<T> sample;
+                memcpy(&sample, ptr, sizeof sample);
+                callback(sample);
+            }
+            return true;
+        }
 
-        case Opcode::Statistic:
-            Statistic(target, inst); break;
+        // samples are taken at frame receive time minus its age, kept in order even if ages are not
+        int64_t BatchedSampleTimestamp(int64_t received, uint32_t age_us, int64_t previous)
+        {
+            int64_t timestamp = received - static_cast<int64_t>(age_us) * 1000;
+            return timestamp < previous ? previous : timestamp;
+        }
+    }
 
-        case Opcode::Debug:
-            Debug(target, inst); break;
+    constexpr std::array<InstructionHandler::OpcodeEntry, 256> InstructionHandler::BuildOpcodeTable()
+    {
+        using Status = Tracker::ConnectionStatus;
+
+        std::array<OpcodeEntry, 256> table{};
+        for (OpcodeEntry& entry : table)
+            entry = OpcodeEntry{ nullptr, Status::Disconnected, 0, 0 };
+
+        // length and alignment come from the reply part of the hint
+        auto set = [&table](const InstructionHint& hint, HandlerFunc handler, Status min_connection)
+            {
+                table[static_cast<uint8_t>(hint.opcode)] = OpcodeEntry{ handler, min_connection, hint.reply_length, hint.reply_align };
+            };
+
+        // network, handshake and heartbeat handle connection transition by themselves
+        set(InstructionSet::Handshake1,     &InstructionHandler::Handshake1,     Status::Disconnected);
+        set(InstructionSet::Handshake2,     &InstructionHandler::Handshake2,     Status::Disconnected);
+        set(InstructionSet::Heartbeat,      &InstructionHandler::Heartbeat,      Status::Disconnected);
+        set(InstructionSet::Ping,           &InstructionHandler::Ping,           Status::Disconnected);
+        set(InstructionSet::Pong,           &InstructionHandler::Pong,           Status::Connected);
+
+        // miscellanous
+        set(InstructionSet::Locate,         &InstructionHandler::Locate,         Status::Disconnected);
+        set(InstructionSet::ClientName,     &InstructionHandler::ClientName,     Status::Connected);
+
+        // configuration
+        set(InstructionSet::Behavior,       &InstructionHandler::Behavior,       Status::Connected);
+        set(InstructionSet::CalibrationGr,  &InstructionHandler::GyrTransform,   Status::Connected);
+        set(InstructionSet::CalibrationAc,  &InstructionHandler::AccTransform,   Status::Connected);
+        set(InstructionSet::CalibrationMg,  &InstructionHandler::MagTransform,   Status::Connected);
+        set(InstructionSet::NoiseVariance,  &InstructionHandler::NoiseVariance,  Status::Connected);
+
+        // data transfer
+        set(InstructionSet::Status,         &InstructionHandler::Status,         Status::Disconnected);
+        set(InstructionSet::Raw,            &InstructionHandler::Raw,            Status::Connected);
+        set(InstructionSet::Nominal,        &InstructionHandler::Nominal,        Status::Connected);
+        set(InstructionSet::Statistic,      &InstructionHandler::Statistic,      Status::Connected);
+        set(InstructionSet::RawBatch,       &InstructionHandler::RawBatch,       Status::Connected);
+        set(InstructionSet::NominalBatch,   &InstructionHandler::NominalBatch,   Status::Connected);
+        set(InstructionSet::NominalCompact, &InstructionHandler::NominalCompact, Status::Connected);
+        set(InstructionSet::Debug,          &InstructionHandler::Debug,          Status::Connected);
+
+        return table;
+    }
 
+    static_assert(kMaxBatchSamples<RawDataSet> > 1 && kMaxBatchSamples<NominalDataSet> > 1);
+    static_assert(kMaxCompactSamples > kMaxBatchSamples<NominalDataSet>);
 
-            // unknown opcode
-        default:
+    void InstructionHandler::Handle(Tracker* target, Instruction& inst, int64_t received)
+    {
+        // built at compile time, a static constexpr member would need its initializer inside the class where handlers are incomplete
+        static constexpr std::array<OpcodeEntry, 256> kOpcodeTable = BuildOpcodeTable();
+        const OpcodeEntry& entry = kOpcodeTable[inst.opcode];
+        if (entry.handler == nullptr)
         {
             unsigned long ip = target->address();
             unsigned char* ptr = reinterpret_cast<unsigned char*>(&ip);
             logger_.Error(
+                unknown_opcode_log_limit_, ip,
                 "Unknown instruction(0x{:x}) received from {:d}.{:d}.{:d}.{:d}",
                 inst.opcode,
                 ptr[0], ptr[1], ptr[2], ptr[3]
             );
-            break;
+            return;
+        }
+
+        if (target->connection_status() < entry.min_connection)
+            return;
+
+        if (inst.length < entry.min_length || (entry.align && inst.align != entry.align))
+        {
+            LogMalformed(target, inst);
+            return;
         }
-        }	// switch case
+
+        (this->*entry.handler)(target, inst, received);
     }
 
-    void InstructionHandler::Handshake1(Tracker* target, Instruction& inst)
+    void InstructionHandler::LogMalformed(const Tracker* target, const Instruction& inst)
+    {
+        unsigned long ip = target->address();
+        unsigned char* ptr = reinterpret_cast<unsigned char*>(&ip);
+        logger_.Error(
+            malformed_log_limit_, ip,
+            "Malformed instruction(0x{:x}, length {} / align {}) received from {:d}.{:d}.{:d}.{:d}",
+            inst.opcode, inst.length, inst.align,
+            ptr[0], ptr[1], ptr[2], ptr[3]
+        );
+    }
+
+    void InstructionHandler::Handshake1(Tracker* target, Instruction& inst, int64_t received)
     {
         if (target->IsDisconnected()) 
         {
+            // client without the version field speaks v1
+            uint8_t version = inst.length >= 1 ? inst.payload[0].uchar[0] : kProtocolVersion1;
+            target->set_protocol_version(std::clamp(version, kProtocolVersion1, kProtocolVersion));
             target->SetHandshaked();
 #ifdef DKVR_DEBUG_TRACKER_CONNECTION_DETAIL
             unsigned long ip = target->address();
@@ -106,13 +158,13 @@ namespace dkvr
         }
     }
 
-    void InstructionHandler::Handshake2(Tracker* target, Instruction& inst)
+    void InstructionHandler::Handshake2(Tracker* target, Instruction& inst, int64_t received)
     {
         // host side opcode
         logger_.Debug("Host-side opcode(Handshake2) received.");
     }
 
-    void InstructionHandler::Heartbeat(Tracker* target, Instruction& inst)
+    void InstructionHandler::Heartbeat(Tracker* target, Instruction& inst, int64_t received)
     {
         if (target->IsHandshaked())
         {
@@ -123,122 +175,156 @@ namespace dkvr
             logger_.Debug("Tracker connected (ip {:d}.{:d}.{:d}.{:d})", ptr[0], ptr[1], ptr[2], ptr[3]);
 #endif
         }
-        target->UpdateHeartbeatRecv();
+        target->UpdateHeartbeatRecv(received);
     }
 
-    void InstructionHandler::Ping(Tracker* target, Instruction& inst)
+    void InstructionHandler::Ping(Tracker* target, Instruction& inst, int64_t received)
     {
         // host side opcdoe
         logger_.Debug("Host-side opcode(Ping) received.");
     }
 
-    void InstructionHandler::Pong(Tracker* target, Instruction& inst)
+    void InstructionHandler::Pong(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
-            target->UpdateRtt();
+        target->UpdateRtt(received);
     }
 
-    void InstructionHandler::Locate(Tracker* target, Instruction& inst)
+    void InstructionHandler::Locate(Tracker* target, Instruction& inst, int64_t received)
     {
         // host side opcode
         logger_.Debug("Host-side opcode(Locate) received.");
     }
 
-    void InstructionHandler::ClientName(Tracker* target, Instruction& inst)
+    void InstructionHandler::ClientName(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
-            target->set_name(reinterpret_cast<char*>(inst.payload));
+        const char* str = reinterpret_cast<const char*>(inst.payload);
+        std::string name(str, strnlen(str, sizeof(inst.payload)));
+        target->set_name(name);
+        tk_provider_.UpdateName(target->address(), name);
     }
 
-    void InstructionHandler::Behavior(Tracker* target, Instruction& inst)
+    void InstructionHandler::Behavior(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
-        {
-            if (inst.payload[0].uchar[0] == target->behavior_encoded())
-                target->SetBehaviorSynced();
-        }
+        if (inst.payload[0].uchar[0] == target->behavior_encoded())
+            target->SetBehaviorSynced();
     }
 
-    void InstructionHandler::GyrTransform(Tracker* target, Instruction& inst)
+    void InstructionHandler::GyrTransform(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
-        {
-            uint8_t hash = Hash::Pearson(kCalibTransformSize, target->calibration_cref().gyr_transform);
-            if (hash == inst.payload[0].uchar[0])
-                target->SetGyrTransformSynced();
-        }
+        uint8_t hash = Hash::Pearson(kCalibTransformSize, target->calibration_cref().gyr_transform);
+        if (hash == inst.payload[0].uchar[0])
+            target->SetGyrTransformSynced();
     }
 
-    void InstructionHandler::AccTransform(Tracker* target, Instruction& inst)
+    void InstructionHandler::AccTransform(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
-        {
-            uint8_t hash = Hash::Pearson(kCalibTransformSize, target->calibration_cref().acc_transform);
-            if (hash == inst.payload[0].uchar[0])
-                target->SetAccTransformSynced();
-        }
+        uint8_t hash = Hash::Pearson(kCalibTransformSize, target->calibration_cref().acc_transform);
+        if (hash == inst.payload[0].uchar[0])
+            target->SetAccTransformSynced();
     }
 
-    void InstructionHandler::MagTransform(Tracker* target, Instruction& inst)
+    void InstructionHandler::MagTransform(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
-        {
-            uint8_t hash = Hash::Pearson(kCalibTransformSize, target->calibration_cref().mag_transform);
-            if (hash == inst.payload[0].uchar[0])
-                target->SetMagTransformSynced();
-        }
+        uint8_t hash = Hash::Pearson(kCalibTransformSize, target->calibration_cref().mag_transform);
+        if (hash == inst.payload[0].uchar[0])
+            target->SetMagTransformSynced();
     }
 
-    void InstructionHandler::NoiseVariance(Tracker* target, Instruction& inst)
+    void InstructionHandler::NoiseVariance(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
-        {
-            uint8_t hash = Hash::Pearson(kCalibNoiseVarSize, target->calibration_cref().noise_variance);
-            if (hash == inst.payload[0].uchar[0])
-                target->SetNoiseVarianceSynced();
-        }
+        uint8_t hash = Hash::Pearson(kCalibNoiseVarSize, target->calibration_cref().noise_variance);
+        if (hash == inst.payload[0].uchar[0])
+            target->SetNoiseVarianceSynced();
     }
 
-    void InstructionHandler::Status(Tracker* target, Instruction& inst)
+    void InstructionHandler::Status(Tracker* target, Instruction& inst, int64_t received)
     {
         TrackerStatus* status = reinterpret_cast<TrackerStatus*>(inst.payload);
         target->set_tracker_status(*status);
     }
 
-    void InstructionHandler::Raw(Tracker* target, Instruction& inst)
+    void InstructionHandler::Raw(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected()) 
-        {
-            RawDataSet* data = reinterpret_cast<RawDataSet*>(inst.payload);
-            target->set_raw_data(*data);
-        }
+        RawDataSet* data = reinterpret_cast<RawDataSet*>(inst.payload);
+        target->set_raw_data(*data, inst.sequence, received);
     }
 
-    void InstructionHandler::Nominal(Tracker* target, Instruction& inst)
+    void InstructionHandler::Nominal(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected()) 
-        {
-            NominalDataSet* data = reinterpret_cast<NominalDataSet*>(inst.payload);
-            target->set_nominal_data(*data);
-        }
+        NominalDataSet* data = reinterpret_cast<NominalDataSet*>(inst.payload);
+        target->set_nominal_data(*data, inst.sequence, received);
     }
 
-    void InstructionHandler::Statistic(Tracker* target, Instruction& inst)
+    void InstructionHandler::Statistic(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
-        {
-            TrackerStatistic* statistic = reinterpret_cast<TrackerStatistic*>(&inst.payload);
-            target->set_tracker_statistic(*statistic);
-        }
+        TrackerStatistic* statistic = reinterpret_cast<TrackerStatistic*>(&inst.payload);
+        target->set_tracker_statistic(*statistic);
+    }
+
+    void InstructionHandler::RawBatch(Tracker* target, Instruction& inst, int64_t received)
+    {
+        if (target->protocol_version() < kProtocolVersion2)
+            return;
+
+        int64_t previous = 0;
+        bool valid = ForEachBatchedSample<RawDataSet>(inst, [&](const BatchedSample<RawDataSet>& sample)
+            {
+                previous = BatchedSampleTimestamp(received, sample.age_us, previous);
+                target->set_raw_data(sample.data, inst.sequence, previous);
+            });
+
+        if (!valid)
+            LogMalformed(target, inst);
     }
 
-    void InstructionHandler::Debug(Tracker* target, Instruction& inst)
+    void InstructionHandler::NominalBatch(Tracker* target, Instruction& inst, int64_t received)
     {
-        if (target->IsConnected())
+        if (target->protocol_version() < kProtocolVersion2)
+            return;
+
+        int64_t previous = 0;
+        bool valid = ForEachBatchedSample<NominalDataSet>(inst, [&](const BatchedSample<NominalDataSet>& sample)
+            {
+                previous = BatchedSampleTimestamp(received, sample.age_us, previous);
+                target->set_nominal_data(sample.data, inst.sequence, previous);
+            });
+
+        if (!valid)
+            LogMalformed(target, inst);
+    }
+
+    void InstructionHandler::NominalCompact(Tracker* target, Instruction& inst, int64_t received)
+    {
+        if (target->protocol_version() < kProtocolVersion3)
+            return;
+
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(inst.payload);
+        uint8_t count = payload[0];
+        if (count == 0 || count > kMaxCompactSamples || sizeof count + count * kCompactSampleSize > inst.length)
         {
-            TrackerDebug* debug = reinterpret_cast<TrackerDebug*>(&inst.payload);
-            logger_.Debug("{} (dkvr_err {:#04x} / timestamp {}) from {}.", debug->msg, debug->dkvr_err, debug->timestamp, target->name());
+            LogMalformed(target, inst);
+            return;
         }
+
+        const uint8_t* samples = payload + sizeof count;
+        NominalDataSet data[kMaxCompactSamples];
+        CompactNominal::DecodeBatch(samples + sizeof(uint16_t), kCompactSampleSize, count, data);
+
+        int64_t previous = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            const uint8_t* ptr = samples + i * kCompactSampleSize;
+            uint16_t age_us = static_cast<uint16_t>(ptr[0] | (ptr[1] << 8));
+            previous = BatchedSampleTimestamp(received, age_us, previous);
+            target->set_nominal_data(data[i], inst.sequence, previous);
+        }
+    }
+
+    void InstructionHandler::Debug(Tracker* target, Instruction& inst, int64_t received)
+    {
+        TrackerDebug* debug = reinterpret_cast<TrackerDebug*>(&inst.payload);
+        std::string_view msg(debug->msg, strnlen(debug->msg, sizeof(debug->msg)));
+        logger_.Debug("{} (dkvr_err {:#04x} / timestamp {}) from {}.", msg, debug->dkvr_err, debug->timestamp, target->name());
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "controller/pose_publisher.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#	include <Windows.h>
+#else
+#	include <cerrno>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+namespace dkvr
+{
+
+    namespace
+    {
+        constexpr std::chrono::milliseconds kPublishInterval(1);
+        constexpr size_t kSlotWordCount = sizeof(DKVRPoseSlot) / sizeof(uint32_t);
+
+        static_assert(sizeof(DKVRPoseSlot) % sizeof(uint32_t) == 0);
+        static_assert(offsetof(DKVRPoseSlot, sequence) == 0);
+        static_assert(DKVR_POSE_SHM_SLOT_CAPACITY >= TrackerProvider::kMaxTrackers, "every tracker must have a slot.");
+    }
+
+    PosePublisher::PosePublisher(TrackerProvider& tk_provider) :
+        publisher_thread_(*this, "pose publisher"),
+        name_(),
+        segment_(nullptr),
+        segment_size_(sizeof(DKVRPoseShmHeader) + sizeof(DKVRPoseSlot) * DKVR_POSE_SHM_SLOT_CAPACITY),
+#ifdef _WIN32
+        mapping_handle_(nullptr),
+#else
+        shm_fd_(-1),
+#endif
+        last_timestamp_{},
+        last_connection_{},
+        tk_provider_(tk_provider)
+    {
+        publisher_thread_ += &PosePublisher::PublishPoses;
+    }
+
+    PosePublisher::~PosePublisher()
+    {
+        Stop();
+    }
+
+    int PosePublisher::Run(const std::string& name)
+    {
+        if (IsRunning())
+            return 0;
+
+        name_ = name.empty() ? DKVR_POSE_SHM_DEFAULT_NAME : name;
+        if (MapSegment())
+            return 1;
+
+        // every slot is written at least once
+        for (size_t i = 0; i < DKVR_POSE_SHM_SLOT_CAPACITY; i++)
+        {
+            last_timestamp_[i] = -1;
+            last_connection_[i] = UINT32_MAX;
+        }
+
+        publisher_thread_.Run();
+        logger_.Info("Pose publisher launched on shared memory {}.", name_);
+
+        return 0;
+    }
+
+    void PosePublisher::Stop()
+    {
+        if (!IsRunning())
+            return;
+
+        publisher_thread_.Stop();
+        UnmapSegment();
+        logger_.Debug("Pose publisher closed.");
+    }
+
+    int PosePublisher::MapSegment()
+    {
+#ifdef _WIN32
+        // Win32 mapping names can't begin with '/', keep it session local
+        std::string mapping_name = "Local\\" + (name_.front() == '/' ? name_.substr(1) : name_);
+        HANDLE mapping = CreateFileMappingA(
+            INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(segment_size_), mapping_name.c_str());
+        if (mapping == nullptr)
+        {
+            logger_.Error("Shared memory creation failed : {}", GetLastError());
+            return 1;
+        }
+
+        segment_ = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, segment_size_);
+        if (segment_ == nullptr)
+        {
+            logger_.Error("Shared memory mapping failed : {}", GetLastError());
+            CloseHandle(mapping);
+            return 1;
+        }
+        mapping_handle_ = mapping;
+#else
+        shm_fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+        if (shm_fd_ == -1)
+        {
+            logger_.Error("Shared memory creation failed : {}", std::strerror(errno));
+            return 1;
+        }
+
+        if (ftruncate(shm_fd_, static_cast<off_t>(segment_size_)))
+        {
+            logger_.Error("Shared memory resize failed : {}", std::strerror(errno));
+            close(shm_fd_);
+            shm_fd_ = -1;
+            return 1;
+        }
+
+        void* ptr = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd_, 0);
+        if (ptr == MAP_FAILED)
+        {
+            logger_.Error("Shared memory mapping failed : {}", std::strerror(errno));
+            close(shm_fd_);
+            shm_fd_ = -1;
+            return 1;
+        }
+        segment_ = ptr;
+#endif
+
+        // readers check magic last, publish it after everything else
+        std::memset(segment_, 0, segment_size_);
+        DKVRPoseShmHeader* hdr = header();
+        hdr->layout_version = DKVR_POSE_SHM_LAYOUT_VER;
+        hdr->header_size = sizeof(DKVRPoseShmHeader);
+        hdr->slot_size = sizeof(DKVRPoseSlot);
+        hdr->slot_capacity = DKVR_POSE_SHM_SLOT_CAPACITY;
+        std::atomic_ref<uint32_t>(hdr->magic).store(DKVR_POSE_SHM_MAGIC, std::memory_order_release);
+
+        return 0;
+    }
+
+    void PosePublisher::UnmapSegment()
+    {
+        if (segment_ == nullptr)
+            return;
+
+        // tell the readers the segment is abandoned
+        std::atomic_ref<uint32_t>(header()->magic).store(0, std::memory_order_release);
+
+#ifdef _WIN32
+        UnmapViewOfFile(segment_);
+        CloseHandle(static_cast<HANDLE>(mapping_handle_));
+        mapping_handle_ = nullptr;
+#else
+        // readers which already mapped the segment keep it until they unmap
+        munmap(segment_, segment_size_);
+        close(shm_fd_);
+        shm_unlink(name_.c_str());
+        shm_fd_ = -1;
+#endif
+        segment_ = nullptr;
+    }
+
+    void PosePublisher::PublishPoses()
+    {
+        size_t count = 0;
+        bool updated = false;
+
+        TrackerSnapshot snapshot;
+        while (count < DKVR_POSE_SHM_SLOT_CAPACITY && tk_provider_.LoadSnapshot(static_cast<int>(count), snapshot))
+        {
+            uint32_t connection = static_cast<uint32_t>(snapshot.connection);
+            if (snapshot.sample.timestamp != last_timestamp_[count] || connection != last_connection_[count])
+            {
+                WriteSlot(slot(count), snapshot);
+                last_timestamp_[count] = snapshot.sample.timestamp;
+                last_connection_[count] = connection;
+                updated = true;
+            }
+            count++;
+        }
+
+        DKVRPoseShmHeader* hdr = header();
+        std::atomic_ref<uint32_t> tracker_count(hdr->tracker_count);
+        if (tracker_count.load(std::memory_order_relaxed) != count)
+            tracker_count.store(static_cast<uint32_t>(count), std::memory_order_release);
+
+        if (updated)
+            std::atomic_ref<uint64_t>(hdr->frame_counter).fetch_add(1, std::memory_order_release);
+
+        std::this_thread::sleep_for(kPublishInterval);
+    }
+
+    void PosePublisher::WriteSlot(DKVRPoseSlot* slot, const TrackerSnapshot& snapshot)
+    {
+        DKVRPoseSlot data{};
+        data.connection_status = static_cast<uint32_t>(snapshot.connection);
+        data.address = static_cast<uint32_t>(snapshot.address);
+        data.timestamp = snapshot.sample.timestamp;
+        std::memcpy(data.orientation, snapshot.sample.nominal.orientation.data, sizeof data.orientation);
+        std::memcpy(data.linear_acceleration, snapshot.sample.nominal.linear_acceleration.data, sizeof data.linear_acceleration);
+        std::memcpy(data.magnetic_disturbance, snapshot.sample.nominal.magnetic_disturbance.data, sizeof data.magnetic_disturbance);
+        std::memcpy(data.raw_gyro, snapshot.sample.raw.gyr.data, sizeof data.raw_gyro);
+        std::memcpy(data.raw_accel, snapshot.sample.raw.acc.data, sizeof data.raw_accel);
+        std::memcpy(data.raw_mag, snapshot.sample.raw.mag.data, sizeof data.raw_mag);
+
+        uint32_t words[kSlotWordCount];
+        std::memcpy(words, &data, sizeof(DKVRPoseSlot));
+        uint32_t* dst = reinterpret_cast<uint32_t*>(slot);
+
+        std::atomic_ref<uint32_t> sequence(slot->sequence);
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // word 0 is the sequence itself
+        for (size_t i = 1; i < kSlotWordCount; i++)
+            std::atomic_ref<uint32_t>(dst[i]).store(words[i], std::memory_order_relaxed);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    DKVRPoseSlot* PosePublisher::slot(size_t index) const
+    {
+        char* base = static_cast<char*>(segment_) + sizeof(DKVRPoseShmHeader);
+        return reinterpret_cast<DKVRPoseSlot*>(base) + index;
+    }
+
+}	// namespace dkvr
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "controller/sample_notifier.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace dkvr {
+
+	namespace
+	{
+		constexpr size_t kCallbackBatchSize = 8;
+	}
+
+	SampleNotifier::SampleNotifier(const TrackerProvider& tk_provider) :
+		callback_mutex_(),
+		callback_registered_(false),
+		callback_(nullptr),
+		callback_context_(nullptr),
+		counters_{},
+		wakeup_count_(0),
+		waiters_(0),
+		wait_mutex_(),
+		wait_cv_(),
+		tk_provider_(tk_provider)
+	{ }
+
+	void SampleNotifier::RegisterCallback(Callback callback, void* context)
+	{
+		// waits for the running callback to return
+		std::lock_guard<std::mutex> lock(callback_mutex_);
+		callback_ = callback;
+		callback_context_ = context;
+		callback_registered_.store(callback != nullptr, std::memory_order_release);
+	}
+
+	bool SampleNotifier::WaitForSamples(std::chrono::milliseconds timeout, uint64_t mask)
+	{
+		if (mask == 0)
+			return false;
+
+		// register as a waiter before taking the snapshot, so that Notify() never skips the wakeup
+		waiters_.fetch_add(1);
+		uint64_t wakeup = wakeup_count_.load();
+		uint64_t snapshot[kMaskBits];
+		for (size_t i = 0; i < kMaskBits; i++)
+			snapshot[i] = counters_[i].load();
+
+		auto arrived = [&]() {
+			for (size_t i = 0; i < kMaskBits; i++)
+			{
+				if ((mask >> i & 1) && counters_[i].load() != snapshot[i])
+					return true;
+			}
+			return false;
+		};
+
+		bool result;
+		{
+			std::unique_lock<std::mutex> lock(wait_mutex_);
+			wait_cv_.wait_for(lock, timeout, [&]() { return arrived() || wakeup_count_.load() != wakeup; });
+			result = arrived();
+		}
+		waiters_.fetch_sub(1);
+
+		return result;
+	}
+
+	void SampleNotifier::Notify(int index, uint64_t begin, uint64_t end)
+	{
+		// negative index is no tracker, there is no bit to wake
+		if (begin == end || index < 0)
+			return;
+
+		counters_[BitOf(static_cast<size_t>(index))].fetch_add(end - begin);
+		if (waiters_.load() > 0)
+		{
+			// waiter is either before its predicate check or blocked, never in between
+			{ std::lock_guard<std::mutex> lock(wait_mutex_); }
+			wait_cv_.notify_all();
+		}
+
+		InvokeCallback(index, begin, end);
+	}
+
+	void SampleNotifier::WakeupAll()
+	{
+		wakeup_count_.fetch_add(1);
+		{ std::lock_guard<std::mutex> lock(wait_mutex_); }
+		wait_cv_.notify_all();
+	}
+
+	void SampleNotifier::InvokeCallback(int index, uint64_t begin, uint64_t end)
+	{
+		// workers of different shards never meet here unless a callback is registered
+		if (!callback_registered_.load(std::memory_order_acquire))
+			return;
+
+		// callback_ is checked again, it may have been unregistered meanwhile
+		std::lock_guard<std::mutex> lock(callback_mutex_);
+		if (callback_ == nullptr)
+			return;
+
+		TimedSample batch[kCallbackBatchSize];
+		uint64_t cursor = begin;
+		uint64_t lost = 0;
+		while (cursor < end)
+		{
+			size_t count = tk_provider_.ReadSamples(index, cursor, batch, std::min<uint64_t>(end - cursor, kCallbackBatchSize), lost);
+			if (count == 0)
+				break;
+
+			for (size_t i = 0; i < count; i++)
+				callback_(callback_context_, index, batch[i]);
+		}
+
+		if (lost)
+			logger_.Debug("{} samples overwritten before sample callback of tracker {}.", lost, index);
+	}
+
+}	// namespace dkvr
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "controller/tracker_updater.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <mutex>
 
 #include "instruction/instruction_set.h"
 
@@ -12,7 +14,7 @@ namespace dkvr
 
     namespace
     {
-        constexpr std::chrono::milliseconds kThreadDelay(1000);
+        constexpr std::chrono::milliseconds kMaxIdle(1000);
         constexpr std::chrono::milliseconds kHeartbeatInterval(1000);
         constexpr std::chrono::milliseconds kTimeoutInterval(5000);
 #ifdef _DEBUG
@@ -22,6 +24,22 @@ namespace dkvr
         constexpr std::chrono::milliseconds kRttUpdateInterval(5000);
         constexpr std::chrono::milliseconds kStatusUpdateInterval(5000);
 #endif
+        // requests and configuration changed without RequestUpdate() are picked up at this interval
+        constexpr std::chrono::milliseconds kRequestPollInterval(1000);
+
+        // unacknowledged configuration is resent after kConfigRetransmitBase, doubled every attempt up to kConfigRetransmitMax
+        // in-flight configuration packets are capped so that many trackers booting at once don't flood the AP
+        constexpr std::chrono::milliseconds kConfigRetransmitBase(200);
+        constexpr std::chrono::milliseconds kConfigRetransmitMax(5000);
+        constexpr std::chrono::milliseconds kConfigPacingInterval(20);     // recheck interval while capped
+        constexpr size_t kConfigInFlightPerTracker = 2;
+        constexpr size_t kConfigInFlightGlobal = 16;
+
+        std::chrono::milliseconds ConfigRetransmitTimeout(uint16_t attempts)
+        {
+            int shift = std::min<int>(attempts > 0 ? attempts - 1 : 0, 5);
+            return std::min(kConfigRetransmitBase * (1 << shift), kConfigRetransmitMax);
+        }
 
         Instruction BuildInstruction(InstructionHint hint, uint32_t seq, const void* payload)
         {
@@ -36,10 +54,26 @@ namespace dkvr
 
     TrackerUpdater::TrackerUpdater(NetworkService& net_service, TrackerProvider& tk_provider) :
         now_(),
-        updater_thread_(*this),
+        wheel_(),
+        timers_{},
+        known_count_(0),
+        config_sync_{},
+        config_in_flight_(0),
+        config_stat_{},
+        updater_thread_(*this, "tracker updater"),
+        requests_(),
+        rescan_required_(false),
+        stopping_(false),
+        wakeup_(false),
+        wakeup_mutex_(),
+        wakeup_cv_(),
         net_service_(net_service),
         tk_provider_(tk_provider)
     { 
+        for (uint32_t index = 0; index < TrackerProvider::kMaxTrackers; index++)
+            for (uint32_t kind = 0; kind < kTimerKindCount; kind++)
+                timers_[index][kind].id = index * kTimerKindCount + kind;
+
         updater_thread_ += &TrackerUpdater::UpdateTracker;
     }
 
@@ -51,56 +85,166 @@ namespace dkvr
 
     void TrackerUpdater::Stop()
     {
+        stopping_ = true;
+        {
+            std::lock_guard<std::mutex> lock(wakeup_mutex_);
+            wakeup_ = true;
+        }
+        wakeup_cv_.notify_one();
+
         updater_thread_.Stop();
+        stopping_ = false;
         logger_.Debug("Tracker updater thread closed.");
     }
 
+    void TrackerUpdater::RequestUpdate(int index)
+    {
+        if (!requests_.Push(index))
+            rescan_required_ = true;
+
+        {
+            std::lock_guard<std::mutex> lock(wakeup_mutex_);
+            wakeup_ = true;
+        }
+        wakeup_cv_.notify_one();
+    }
+
     void TrackerUpdater::UpdateTracker()
     {
         {
-            std::vector<AtomicTracker> trackers = tk_provider_.GetAllTrackers();
-            now_ = std::chrono::steady_clock::now();
+            TraceScope scope(tracer_, "UpdateTracker");
+            HandleRequests();
 
-            // individual tracker update
-            for (AtomicTracker& target : trackers)
-            {
-                UpdateConnection(target);
-                if (!target->IsConnected()) continue;	// don't update if not connected
+            now_ = Clock::now();
+            wheel_.Advance(now_, [this](TimerWheel::Timer& timer) { OnTimer(timer); });
+            tracer_.Counter("config in flight", static_cast<int64_t>(config_in_flight_));
+        }
 
-                UpdateHeartbeatAndRtt(target);
-                HandleUpdateRequired(target);
-                SyncConfigurationWithClient(target);
-            }
+        // sleep until the next deadline, new trackers without any request are found within kMaxIdle
+        Clock::time_point deadline = std::min(wheel_.NextDeadline(), now_ + kMaxIdle);
+        TraceScope scope(tracer_, "wait");
+        std::unique_lock<std::mutex> lock(wakeup_mutex_);
+        wakeup_cv_.wait_until(lock, deadline, [this]() { return wakeup_ || stopping_; });
+        wakeup_ = false;
+    }
+
+    void TrackerUpdater::HandleRequests()
+    {
+        Clock::time_point now = Clock::now();
 
-            // bunch tracker update
-            static std::chrono::time_point last_status_update = std::chrono::steady_clock::now();
-            if ((now_ - last_status_update) >= kStatusUpdateInterval)
+        // newly inserted trackers
+        size_t count = tk_provider_.GetCount();
+        for (; known_count_ < count; known_count_++)
+            Schedule(static_cast<int>(known_count_), kConnection, now);
+
+        if (rescan_required_.exchange(false))
+        {
+            for (size_t index = 0; index < known_count_; index++)
             {
-                for (AtomicTracker& target : trackers)
-                {
-                    UpdateStatusAndStatistic(target);
-                }
+                Schedule(static_cast<int>(index), kConnection, now);
+                Schedule(static_cast<int>(index), kRequest, now);
+                Schedule(static_cast<int>(index), kConfig, now);
+            }
+        }
+
+        int index;
+        while (requests_.TryPop(index))
+        {
+            if (index < 0 || static_cast<size_t>(index) >= known_count_)
+                continue;
+
+            Schedule(index, kConnection, now);
+            Schedule(index, kRequest, now);
+            Schedule(index, kConfig, now);
+        }
+    }
+
+    ConfigSyncStatistic TrackerUpdater::GetConfigSyncStatistic(int index) const
+    {
+        if (index < 0 || static_cast<size_t>(index) >= TrackerProvider::kMaxTrackers)
+            return ConfigSyncStatistic{};
+
+        const AtomicConfigSyncStatistic& stat = config_stat_[index];
+        return ConfigSyncStatistic
+        {
+            .synced = stat.synced.load(std::memory_order_relaxed),
+            .transmissions = stat.transmissions.load(std::memory_order_relaxed),
+            .retransmissions = stat.retransmissions.load(std::memory_order_relaxed),
+            .last_latency_ms = stat.last_latency_ms.load(std::memory_order_relaxed),
+            .max_latency_ms = stat.max_latency_ms.load(std::memory_order_relaxed)
+        };
+    }
+
+    void TrackerUpdater::OnTimer(TimerWheel::Timer& timer)
+    {
+        int index = static_cast<int>(timer.id / kTimerKindCount);
+        TimerKind kind = static_cast<TimerKind>(timer.id % kTimerKindCount);
+
+        AtomicTracker target = tk_provider_.FindByIndex(index);
+        if (!target)
+            return;
+
+        switch (kind)
+        {
+        case kConnection:
+            UpdateConnection(index, target);
+            break;
+
+        case kHeartbeat:
+            UpdateHeartbeat(index, target);
+            break;
+
+        case kPing:
+            UpdateRtt(index, target);
+            break;
 
-                last_status_update = now_;
+        case kStatus:
+            if (!target->IsConnected()) break;
+            UpdateStatusAndStatistic(target);
+            Schedule(index, kStatus, now_ + kStatusUpdateInterval);
+            break;
+
+        case kRequest:
+            if (!target->IsConnected()) break;
+            HandleUpdateRequired(target);
+            Schedule(index, kRequest, now_ + kRequestPollInterval);
+            break;
+
+        case kConfig:
+            if (!target->IsConnected())
+            {
+                ReleaseConfigSync(index);
+                break;
             }
-        }	// Atomic Tracker release
+            Schedule(index, kConfig, SyncConfigurationWithClient(index, target));
+            break;
 
-        // delay
-        std::this_thread::sleep_for(kThreadDelay);
+        default:
+            break;
+        }
     }
 
-    void TrackerUpdater::UpdateConnection(Tracker* target)
+    void TrackerUpdater::Schedule(int index, TimerKind kind, Clock::time_point deadline)
+    {
+        wheel_.Schedule(timers_[index][kind], deadline);
+    }
+
+    void TrackerUpdater::UpdateConnection(int index, Tracker* target)
     {
         switch (target->connection_status())
         {
         default:
         case Tracker::ConnectionStatus::Disconnected:
+            Schedule(index, kConnection, now_ + kHeartbeatInterval);
             break;
 
         case Tracker::ConnectionStatus::Handshaked:
         {
-            Instruction inst = BuildInstruction(InstructionSet::Handshake2, target->send_sequence_num(), nullptr);
-            net_service_.Send(target->address(), inst);
+            // tell the protocol version in use, client falls back to v1 if it doesn't know the field
+            uint8_t version = target->protocol_version();
+            Instruction inst = BuildInstruction(InstructionSet::Handshake2, target->send_sequence_num(), &version);
+            Send(target, inst);
+            Schedule(index, kConnection, now_ + kHeartbeatInterval);
             break;
         }
 
@@ -108,6 +252,8 @@ namespace dkvr
         {
             if ((now_ - target->last_heartbeat_recv()) >= kTimeoutInterval) {
                 target->Reset();
+                ReleaseConfigSync(index);
+                Schedule(index, kConnection, now_ + kHeartbeatInterval);
 #ifdef DKVR_DEBUG_TRACKER_CONNECTION_DETAIL
                 unsigned long ip = target->address();
                 unsigned char* ptr = reinterpret_cast<unsigned char*>(&ip);
@@ -115,23 +261,41 @@ namespace dkvr
 #endif
                 break;
             }
+
+            // heartbeat receive time is checked again when it would have expired
+            Schedule(index, kConnection, target->last_heartbeat_recv() + kTimeoutInterval);
+
+            // periodic timers stop by themselves while not connected, restart them
+            if (!timers_[index][kHeartbeat].armed) Schedule(index, kHeartbeat, now_);
+            if (!timers_[index][kPing].armed)      Schedule(index, kPing, now_);
+            if (!timers_[index][kStatus].armed)    Schedule(index, kStatus, now_ + kStatusUpdateInterval);
+            if (!timers_[index][kRequest].armed)   Schedule(index, kRequest, now_);
+            if (!timers_[index][kConfig].armed)    Schedule(index, kConfig, now_);
+            break;
         }
         }
     }
 
-    void TrackerUpdater::UpdateHeartbeatAndRtt(Tracker* target)
+    void TrackerUpdater::UpdateHeartbeat(int index, Tracker* target)
     {
-        if ((now_ - target->last_heartbeat_sent()) >= kHeartbeatInterval) {
-            Instruction inst = BuildInstruction(InstructionSet::Heartbeat, target->send_sequence_num(), nullptr);
-            net_service_.Send(target->address(), inst);
-            target->UpdateHeartbeatSent();
-        }
+        if (!target->IsConnected())
+            return;
 
-        if ((now_ - target->last_ping_sent()) >= kRttUpdateInterval) {
-            Instruction inst = BuildInstruction(InstructionSet::Ping, target->send_sequence_num(), nullptr);
-            net_service_.Send(target->address(), inst);
-            target->UpdatePingSent();
-        }
+        Instruction inst = BuildInstruction(InstructionSet::Heartbeat, target->send_sequence_num(), nullptr);
+        Send(target, inst);
+        target->UpdateHeartbeatSent();
+        Schedule(index, kHeartbeat, now_ + kHeartbeatInterval);
+    }
+
+    void TrackerUpdater::UpdateRtt(int index, Tracker* target)
+    {
+        if (!target->IsConnected())
+            return;
+
+        Instruction inst = BuildInstruction(InstructionSet::Ping, target->send_sequence_num(), nullptr);
+        Send(target, inst);
+        target->UpdatePingSent();
+        Schedule(index, kPing, now_ + kRttUpdateInterval);
     }
 
     void TrackerUpdater::HandleUpdateRequired(Tracker* target)
@@ -139,60 +303,160 @@ namespace dkvr
         if (target->IsStatisticUpdateRequired())
         {
             Instruction inst = BuildInstruction(InstructionSet::Statistic, target->send_sequence_num(), nullptr);
-            net_service_.Send(target->address(), inst);
+            Send(target, inst);
         }
 
         if (target->IsStatusUpdateRequired())
         {
             Instruction inst = BuildInstruction(InstructionSet::Status, target->send_sequence_num(), nullptr);
-            net_service_.Send(target->address(), inst);
+            Send(target, inst);
         }
 
         if (target->IsLocateRequired())
         {
             Instruction inst = BuildInstruction(InstructionSet::Locate, target->send_sequence_num(), nullptr);
-            net_service_.Send(target->address(), inst);
+            Send(target, inst);
         }
     }
 
-    void TrackerUpdater::SyncConfigurationWithClient(Tracker* target)
+    TrackerUpdater::Clock::time_point TrackerUpdater::SyncConfigurationWithClient(int index, Tracker* target)
     {
-        using ConfigurationKey = TrackerConfiguration::ConfigurationKey;
+        Clock::time_point next = now_ + kRequestPollInterval;
+        ConfigSyncState* states = config_sync_[index];
+        AtomicConfigSyncStatistic& stat = config_stat_[index];
+
+        // acknowledged or changed keys leave the flight first, so their slots are reusable below
+        uint32_t unsynced = target->unsynced_mask();
+        size_t in_flight = 0;
+        for (size_t i = 0; i < kConfigKeyCount; i++)
+        {
+            ConfigurationKey key = ConfigurationKey(i);
+            ConfigSyncState& state = states[i];
+            if (state.attempts == 0)
+                continue;
+
+            bool synced = (unsynced & (1u << i)) == 0;
+            bool changed = target->config_revision(key) != state.revision;
+            if (synced && !changed)
+            {
+                uint32_t latency = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now_ - state.first_sent).count());
+                stat.synced.fetch_add(1, std::memory_order_relaxed);
+                stat.last_latency_ms.store(latency, std::memory_order_relaxed);
+                if (latency > stat.max_latency_ms.load(std::memory_order_relaxed))
+                    stat.max_latency_ms.store(latency, std::memory_order_relaxed);
+            }
+
+            if (synced || changed)
+            {
+                if (state.in_flight)
+                    config_in_flight_--;
+                state = ConfigSyncState{};
+                continue;
+            }
 
-        if (!target->IsAllSynced()) {
-            for (ConfigurationKey key : target->GetEveryUnsynced()) {
-                Instruction inst{};
-                switch (key)
-                {
-                case ConfigurationKey::Behavior:
-                {
-                    uint8_t behavior = target->behavior_encoded();
-                    inst = BuildInstruction(InstructionSet::Behavior, target->send_sequence_num(), &behavior);
-                    break;
-                }
+            // unacknowledged within timeout, the packet is considered lost
+            if (state.in_flight && now_ >= state.retransmit_at)
+            {
+                state.in_flight = false;
+                config_in_flight_--;
+            }
 
-                case ConfigurationKey::GyrTransform:
-                    inst = BuildInstruction(InstructionSet::CalibrationGr, target->send_sequence_num(), target->calibration_cref().gyr_transform);
-                    break;
+            if (state.in_flight)
+            {
+                in_flight++;
+                next = std::min(next, state.retransmit_at);
+            }
+        }
+
+        if (unsynced == 0)
+            return next;
 
-                case ConfigurationKey::AccTransform:
-                    inst = BuildInstruction(InstructionSet::CalibrationAc, target->send_sequence_num(), target->calibration_cref().acc_transform);
-                    break;
+        for (size_t i = 0; i < kConfigKeyCount; i++)
+        {
+            ConfigurationKey key = ConfigurationKey(i);
+            ConfigSyncState& state = states[i];
+            if (state.in_flight || (unsynced & (1u << i)) == 0)
+                continue;
 
-                case ConfigurationKey::MagTransform:
-                    inst = BuildInstruction(InstructionSet::CalibrationMg, target->send_sequence_num(), target->calibration_cref().mag_transform);
-                    break;
+            // lost packet waits for its backoff even if a slot is available
+            if (state.attempts != 0 && now_ < state.retransmit_at)
+            {
+                next = std::min(next, state.retransmit_at);
+                continue;
+            }
 
-                case ConfigurationKey::NoiseVariance:
-                    inst = BuildInstruction(InstructionSet::NoiseVariance, target->send_sequence_num(), target->calibration_cref().noise_variance);
-                    break;
+            if (in_flight >= kConfigInFlightPerTracker || config_in_flight_ >= kConfigInFlightGlobal)
+            {
+                next = std::min(next, now_ + kConfigPacingInterval);
+                break;
+            }
 
-                default:
-                case ConfigurationKey::Size:
-                    continue;
-                }
-                net_service_.Send(target->address(), inst);
+            SendConfiguration(target, key);
+            if (state.attempts == 0)
+            {
+                state.first_sent = now_;
+                state.revision = target->config_revision(key);
+            }
+            else
+            {
+                stat.retransmissions.fetch_add(1, std::memory_order_relaxed);
             }
+            stat.transmissions.fetch_add(1, std::memory_order_relaxed);
+
+            if (state.attempts < UINT16_MAX)
+                state.attempts++;
+            state.retransmit_at = now_ + ConfigRetransmitTimeout(state.attempts);
+            state.in_flight = true;
+            in_flight++;
+            config_in_flight_++;
+            next = std::min(next, state.retransmit_at);
+        }
+
+        return next;
+    }
+
+    void TrackerUpdater::SendConfiguration(Tracker* target, ConfigurationKey key)
+    {
+        Instruction inst{};
+        switch (key)
+        {
+        case ConfigurationKey::Behavior:
+        {
+            uint8_t behavior = target->behavior_encoded();
+            inst = BuildInstruction(InstructionSet::Behavior, target->send_sequence_num(), &behavior);
+            break;
+        }
+
+        case ConfigurationKey::GyrTransform:
+            inst = BuildInstruction(InstructionSet::CalibrationGr, target->send_sequence_num(), target->calibration_cref().gyr_transform);
+            break;
+
+        case ConfigurationKey::AccTransform:
+            inst = BuildInstruction(InstructionSet::CalibrationAc, target->send_sequence_num(), target->calibration_cref().acc_transform);
+            break;
+
+        case ConfigurationKey::MagTransform:
+            inst = BuildInstruction(InstructionSet::CalibrationMg, target->send_sequence_num(), target->calibration_cref().mag_transform);
+            break;
+
+        case ConfigurationKey::NoiseVariance:
+            inst = BuildInstruction(InstructionSet::NoiseVariance, target->send_sequence_num(), target->calibration_cref().noise_variance);
+            break;
+
+        default:
+        case ConfigurationKey::Size:
+            return;
+        }
+        Send(target, inst);
+    }
+
+    void TrackerUpdater::ReleaseConfigSync(int index)
+    {
+        for (ConfigSyncState& state : config_sync_[index])
+        {
+            if (state.in_flight)
+                config_in_flight_--;
+            state = ConfigSyncState{};
         }
     }
 
@@ -200,8 +464,14 @@ namespace dkvr
     {
         Instruction inst1 = BuildInstruction(InstructionSet::Status, target->send_sequence_num(), nullptr);
         Instruction inst2 = BuildInstruction(InstructionSet::Statistic, target->send_sequence_num(), nullptr);
-        net_service_.Send(target->address(), inst1);
-        net_service_.Send(target->address(), inst2);
+        Send(target, inst1);
+        Send(target, inst2);
+    }
+
+    void TrackerUpdater::Send(Tracker* target, Instruction& inst)
+    {
+        if (net_service_.Send(target->address(), inst))
+            target->CountSent(kInstructionHeaderSize + inst.length);
     }
 
 }	// namespace dkvr
\ No newline at end of file
@@ -12,10 +12,15 @@
 
 #include "calibrator/calibration_manager.h"
 #include "controller/instruction_dispatcher.h"
+#include "controller/pose_publisher.h"
+#include "controller/sample_notifier.h"
 #include "controller/tracker_updater.h"
+#include "math/pose_predictor.h"
 #include "network/network_service.h"
 #include "tracker/tracker_provider.h"
+#include "util/event_tracer.h"
 #include "util/logger.h"
+#include "util/pipeline_latency.h"
 
 #define DKVRHOST(handle)	    (static_cast<dkvr::DKVRHost*>(handle))
 #define DKVR_CURRENT_VERSION    (DKVR_HOST_EXPORTED_HEADER_VER)
@@ -41,7 +46,8 @@ namespace dkvr {
     class DKVRHost
     {;
     public:
-        DKVRHost();
+        explicit DKVRHost(size_t dispatcher_workers = 1);
+        ~DKVRHost();
 
         // instance control
         void Run(unsigned long ip, unsigned short port);
@@ -61,6 +67,8 @@ namespace dkvr {
         void SetLoggerLevelError() { logger_.set_level(dkvr::Logger::Level::Error); }
 
         int         GetUncheckedLogCount() const { return logger_.GetUncheckedCount(); }
+        uint64_t    GetDroppedLogCount() const { return logger_.dropped(); }
+        void        SetUncheckedLogCapacity(int bytes) { logger_.set_unchecked_capacity(bytes > 0 ? bytes : 0); }
         std::string GetUncheckedLogOne()
         {
             if (internal_ostream_disabled_)
@@ -118,17 +126,53 @@ namespace dkvr {
         TrackerCalibration GetTrackerCalibration(int index) const { return FindTrackerAndGet(index, &Tracker::calibration, dkvr::TrackerCalibration{}); }
         void SetTrackerCalibration(int index, const TrackerCalibration& calib) { FindTrackerAndSet(index, &Tracker::set_calibration, calib); }
 
-        Vector3f    GetTrackerRawGyro(int index) const              { return FindTrackerAndGet(index, &Tracker::raw_gyro, Vector3f{}); }
-        Vector3f    GetTrackerRawAccel(int index) const             { return FindTrackerAndGet(index, &Tracker::raw_accel, Vector3f{}); }
-        Vector3f    GetTrackerRawMag(int index) const               { return FindTrackerAndGet(index, &Tracker::raw_mag, Vector3f{}); }
-        Quaternionf GetTrackerOrientation(int index) const          { return FindTrackerAndGet(index, &Tracker::orientation, Quaternionf{}); }
-        Vector3f    GetTrackerLinearAcceleration(int index) const   { return FindTrackerAndGet(index, &Tracker::linear_acceleration, Vector3f{}); }
-        Vector3f    GetTrackerMagneticDisturbance(int index) const  { return FindTrackerAndGet(index, &Tracker::magnetic_disturbance, Vector3f{}); }
+        // data getters are wait-free, never contend with the dispatcher
+        Vector3f    GetTrackerRawGyro(int index) const              { return LoadRawData(index).gyr; }
+        Vector3f    GetTrackerRawAccel(int index) const             { return LoadRawData(index).acc; }
+        Vector3f    GetTrackerRawMag(int index) const               { return LoadRawData(index).mag; }
+        Quaternionf GetTrackerOrientation(int index) const          { return LoadNominalData(index).orientation; }
+        Vector3f    GetTrackerLinearAcceleration(int index) const   { return LoadNominalData(index).linear_acceleration; }
+        Vector3f    GetTrackerMagneticDisturbance(int index) const  { return LoadNominalData(index).magnetic_disturbance; }
+
+        bool GetTrackerSnapshot(int index, TrackerSnapshot& out) const { return tk_provider_.LoadSnapshot(index, out); }
+        bool   PredictTrackerOrientation(int index, int64_t timestamp, Quaternionf& out) const { return predictor_.Predict(index, timestamp, out); }
+        size_t PredictTrackerOrientationAll(int64_t timestamp, Quaternionf* out, size_t capacity) const { return predictor_.PredictAll(timestamp, out, capacity); }
+
+        uint64_t GetTrackerSampleCursor(int index) const                { return tk_provider_.GetSampleCursor(index); }
+        size_t   ReadTrackerSamples(int index, uint64_t& cursor, TimedSample* out, size_t max, uint64_t& lost) const
+        {
+            return tk_provider_.ReadSamples(index, cursor, out, max, lost);
+        }
 
         void RequestTrackerStatistic(int index) { FindTrackerAndCall(index, &Tracker::RequestStatisticUpdate); }
         void RequestTrackerStatus(int index) { FindTrackerAndCall(index, &Tracker::RequestStatusUpdate); }
         void RequestTrackerLocate(int index) { FindTrackerAndCall(index, &Tracker::RequestLocate); }
 
+        ConfigSyncStatistic GetTrackerConfigSyncStatistic(int index) const { return tracker_updater_.GetConfigSyncStatistic(index); }
+
+        // pipeline latency
+        LatencySnapshot GetLatencySnapshot(int stage) const
+        {
+            if (stage < 0 || stage >= static_cast<int>(PipelineLatency::kStageCount))
+                return LatencySnapshot{};
+            return latency_.Snapshot(static_cast<LatencyStage>(stage));
+        }
+        void ResetLatency() { latency_.Reset(); }
+
+        // network counters
+        bool GetTrackerNetworkCounters(int index, TrackerNetworkCounters& out) const { return tk_provider_.LoadNetworkCounters(index, out); }
+        UDPServer::TrafficStatistic         GetTrafficStatistic() const         { return net_service_.traffic_statistic(); }
+        UDPServer::InvalidDatagramStatistic GetInvalidDatagramStatistic() const { return net_service_.invalid_statistic(); }
+        UDPServer::BatchStatistic           GetBatchStatistic() const           { return net_service_.batch_statistic(); }
+        uint64_t GetReceivedDropped() const { return net_service_.received_dropped(); }
+        uint64_t GetSendingDropped() const  { return net_service_.sending_dropped(); }
+
+        // event tracing
+        void StartTrace()       { tracer_.Start(); }
+        void StopTrace()        { tracer_.Stop(); }
+        bool IsTracing() const  { return tracer_.IsEnabled(); }
+        bool DumpTrace(const std::string& path) const { return tracer_.Dump(path); }
+
         // calibrator
         CalibrationManager::CalibratorStatus GetCalibratorStatus() const { return calib_manager_.GetStatus(); }
         std::string GetCalibratorStatusAsString() const             { return calib_manager_.GetStatusAsString(); }
@@ -140,10 +184,39 @@ namespace dkvr {
         void        AbortCalibration()              { calib_manager_.Abort(); }
         void        ContinueCalibration()           { calib_manager_.Continue(); }
 
+        // sample notification
+        void RegisterSampleCallback(DKVRSampleCallback callback, void* context)
+        {
+            // make sure the previous callback is not running before replacing it
+            sample_notifier_.RegisterCallback(nullptr, nullptr);
+            exported_callback_ = ExportedSampleCallback{ callback, context };
+            if (callback)
+                sample_notifier_.RegisterCallback(&DKVRHost::InvokeSampleCallback, &exported_callback_);
+        }
+        bool WaitForSamples(int timeout_ms, uint64_t mask) { return sample_notifier_.WaitForSamples(std::chrono::milliseconds(timeout_ms), mask); }
+
+        // pose publisher
+        bool RunPosePublisher(const std::string& name) { return !pose_publisher_.Run(name); }
+        void StopPosePublisher()                       { pose_publisher_.Stop(); }
+        bool IsPosePublisherRunning() const            { return pose_publisher_.IsRunning(); }
+
     private:
+        struct ExportedSampleCallback
+        {
+            DKVRSampleCallback callback;
+            void* context;
+        };
+
+        static void InvokeSampleCallback(void* context, int index, const TimedSample& sample)
+        {
+            ExportedSampleCallback* exported = static_cast<ExportedSampleCallback*>(context);
+            exported->callback(exported->context, index, reinterpret_cast<const DKVRTimedSample*>(&sample));
+        }
+
         template <typename T>
         T FindTrackerAndGet(int index, T(Tracker::* getter)(void) const, T not_found = T(0)) const
         {
+            TraceScope scope(tracer_, "DKVRHost::FindTrackerAndGet");     // tracker is held until the end
             ConstAtomicTracker target = tk_provider_.FindByIndex(index);
             return target ? (target->*getter)() : not_found;
         }
@@ -151,36 +224,68 @@ namespace dkvr {
         template <typename T>
         void FindTrackerAndSet(int index, void(Tracker::* setter)(T), const T arg)
         {
+            TraceScope scope(tracer_, "DKVRHost::FindTrackerAndSet");
             AtomicTracker target = tk_provider_.FindByIndex(index);
             if (target)
+            {
                 (target->*setter)(arg);
+                tracker_updater_.RequestUpdate(index);
+            }
+        }
+
+        RawDataSet LoadRawData(int index) const
+        {
+            RawDataSet data{};
+            tk_provider_.LoadRawData(index, data);
+            return data;
+        }
+
+        NominalDataSet LoadNominalData(int index) const
+        {
+            NominalDataSet data{};
+            tk_provider_.LoadNominalData(index, data);
+            return data;
         }
 
         void FindTrackerAndCall(int index, void(Tracker::* callback)(void))
         {
+            TraceScope scope(tracer_, "DKVRHost::FindTrackerAndCall");
             AtomicTracker target = tk_provider_.FindByIndex(index);
             if (target)
+            {
                 (target->*callback)();
+                tracker_updater_.RequestUpdate(index);
+            }
         }
 
+        PipelineLatency latency_;
         NetworkService net_service_;
         TrackerProvider tk_provider_;
-        InstructionDispatcher inst_dispatcher_;
+        SampleNotifier sample_notifier_;
         TrackerUpdater tracker_updater_;
+        InstructionDispatcher inst_dispatcher_;
         CalibrationManager calib_manager_;
+        PosePublisher pose_publisher_;
+        PosePredictor predictor_;
         Logger& logger_ = Logger::GetInstance();
+        EventTracer& tracer_ = EventTracer::GetInstance();
 
+        ExportedSampleCallback exported_callback_{};
         bool is_running_ = false;
         bool internal_ostream_disabled_ = false;
         std::stringstream logger_output_;
     };
 
-    DKVRHost::DKVRHost() try :
-        net_service_(),
+    DKVRHost::DKVRHost(size_t dispatcher_workers) try :
+        latency_(),
+        net_service_(latency_, dispatcher_workers),
         tk_provider_(),
-        inst_dispatcher_(net_service_, tk_provider_),
+        sample_notifier_(tk_provider_),
         tracker_updater_(net_service_, tk_provider_),
-        calib_manager_(tk_provider_)
+        inst_dispatcher_(net_service_, tk_provider_, sample_notifier_, tracker_updater_, latency_),
+        calib_manager_(tk_provider_),
+        pose_publisher_(tk_provider_),
+        predictor_(tk_provider_)
     {
 #ifdef _DEBUG
         logger_.set_level(dkvr::Logger::Level::Debug);
@@ -189,12 +294,19 @@ namespace dkvr {
 #endif
         logger_.set_mode(dkvr::Logger::Mode::Burst);
         logger_.set_ostream(logger_output_);
+        logger_.StartFormatter();
     }
     catch (const std::runtime_error&)
     {
         throw;	// just rethrow it
     }
 
+    DKVRHost::~DKVRHost()
+    {
+        // logs of members being destroyed are written synchronously
+        logger_.StopFormatter();
+    }
+
     void DKVRHost::Run(unsigned long ip, unsigned short port)
     {
         if (is_running_) return;
@@ -215,6 +327,7 @@ namespace dkvr {
         tracker_updater_.Stop();
         inst_dispatcher_.Stop();
         net_service_.Stop();
+        sample_notifier_.WakeupAll();
 
         is_running_ = false;
     }
@@ -242,11 +355,21 @@ static_assert(offsetof(DKVRCalibration, acc_transform)  == offsetof(dkvr::Tracke
 static_assert(offsetof(DKVRCalibration, mag_transform)  == offsetof(dkvr::TrackerCalibration, mag_transform));
 static_assert(offsetof(DKVRCalibration, noise_variance) == offsetof(dkvr::TrackerCalibration, noise_variance));
 
+static_assert(sizeof DKVRTimedSample == sizeof dkvr::TimedSample);
+static_assert(offsetof(DKVRTimedSample, timestamp) == offsetof(dkvr::TimedSample, timestamp));
+static_assert(offsetof(DKVRTimedSample, sequence)  == offsetof(dkvr::TimedSample, sequence));
+static_assert(offsetof(DKVRTimedSample, kind)      == offsetof(dkvr::TimedSample, kind));
+static_assert(offsetof(DKVRTimedSample, data)      == offsetof(dkvr::TimedSample, raw));
+static_assert(static_cast<int>(dkvr::SampleKind::Raw) == Raw && static_cast<int>(dkvr::SampleKind::Nominal) == Nominal);
+static_assert(static_cast<int>(dkvr::LatencyStage::KernelToPublish) == KernelToPublish);
+static_assert(static_cast<int>(dkvr::LatencyStage::Count) == LatencyStageCount);
+
 // version
 void __stdcall dkvrGetVersion(int* out)                             { *out     = DKVR_HOST_EXPORTED_HEADER_VER; }
+void __stdcall dkvrGetHostTimestamp(long long* out)                 { *out     = dkvr::SteadyTimestampNow(); }
 void __stdcall dkvrAssertVersion(int version, int* success) 
 {
-    // version assertion impl. ver : 1003
+    // version assertion impl. ver : 1004
 
     *success = false; // begin with false for unhandled case
 
@@ -256,8 +379,8 @@ void __stdcall dkvrAssertVersion(int version, int* success)
     // same as current
     if (version == DKVR_CURRENT_VERSION) { *success = true; return; }
 
-    // version 1002 is fully compatible with 1003
-    if (version == 1002 || version == 1003) { *success = true; return; }
+    // version 1002 and 1003 are fully compatible with 1004, only functions are added
+    if (version == 1002 || version == 1003 || version == 1004) { *success = true; return; }
 }
 
 // instance control
@@ -269,6 +392,14 @@ void __stdcall dkvrCreateInstance(DKVRHostHandle* hptr, char* msg, int len) {
         StringCopy(except.what(), msg, len);
     }
 }
+void __stdcall dkvrCreateInstanceWithWorkers(DKVRHostHandle* hptr, int dispatcher_workers, char* msg, int len) {
+    try { *hptr = new dkvr::DKVRHost(dispatcher_workers > 0 ? dispatcher_workers : 1); }
+    catch (const std::exception& except)
+    {
+        *hptr = nullptr;
+        StringCopy(except.what(), msg, len);
+    }
+}
 void __stdcall dkvrDeleteInstance(DKVRHostHandle* hptr)                 { delete *hptr; *hptr = nullptr; }
 void __stdcall dkvrRunHost(DKVRHostHandle handle, DKVRAddress address)  { DKVRHOST(handle)->Run(*reinterpret_cast<unsigned long*>(address.ip), address.port); }
 void __stdcall dkvrStopHost(DKVRHostHandle handle)                      { DKVRHOST(handle)->Stop(); }
@@ -284,6 +415,8 @@ void __stdcall dkvrLoggerSetLoggerMode(DKVRHostHandle handle, DKVRLoggerMode mod
 void __stdcall dkvrLoggerGetUncheckCount(DKVRHostHandle handle, int* out)                   { *out = DKVRHOST(handle)->GetUncheckedLogCount(); }
 void __stdcall dkvrLoggerGetUncheckedLogOne(DKVRHostHandle handle, char* out, int len)      { StringCopy(DKVRHOST(handle)->GetUncheckedLogOne(), out, len); }
 void __stdcall dkvrLoggerGetUncheckedLogAll(DKVRHostHandle handle, char* out, int len)      { StringCopy(DKVRHOST(handle)->GetUncheckedLogAll(), out, len); }
+void __stdcall dkvrLoggerSetUncheckedCapacity(DKVRHostHandle handle, int bytes)             { DKVRHOST(handle)->SetUncheckedLogCapacity(bytes); }
+void __stdcall dkvrLoggerGetDroppedCount(DKVRHostHandle handle, unsigned long long* out)    { *out = DKVRHOST(handle)->GetDroppedLogCount(); }
 
 void __stdcall dkvrLoggerSetLevelDebug(DKVRHostHandle handle)                               { DKVRHOST(handle)->SetLoggerLevelDebug(); }
 void __stdcall dkvrLoggerSetLevelInfo(DKVRHostHandle handle)                                { DKVRHOST(handle)->SetLoggerLevelInfo(); }
@@ -324,10 +457,148 @@ void __stdcall dkvrTrackerGetOrientation(DKVRHostHandle handle, int index, DKVRQ
 void __stdcall dkvrTrackerGetLinearAcceleration(DKVRHostHandle handle, int index, DKVRVector3* out) { ReinterpretCast(out, DKVRHOST(handle)->GetTrackerLinearAcceleration(index)); }
 void __stdcall dkvrTrackerGetMagneticDisturbance(DKVRHostHandle handle, int index, DKVRVector3* out) { ReinterpretCast(out, DKVRHOST(handle)->GetTrackerMagneticDisturbance(index)); }
 
+void __stdcall dkvrTrackerGetSnapshotAll(DKVRHostHandle handle, DKVRTrackerSnapshot* out, int capacity, int* count)
+{
+    int filled = 0;
+    dkvr::TrackerSnapshot snapshot;
+    while (filled < capacity && DKVRHOST(handle)->GetTrackerSnapshot(filled, snapshot))
+    {
+        DKVRTrackerSnapshot& dst = out[filled++];
+        dst.address = snapshot.address;
+        dst.connection_status = static_cast<int>(snapshot.connection);
+        ReinterpretCast(&dst.orientation, snapshot.sample.nominal.orientation);
+        ReinterpretCast(&dst.linear_acceleration, snapshot.sample.nominal.linear_acceleration);
+        ReinterpretCast(&dst.magnetic_disturbance, snapshot.sample.nominal.magnetic_disturbance);
+        ReinterpretCast(&dst.raw_gyro, snapshot.sample.raw.gyr);
+        ReinterpretCast(&dst.raw_accel, snapshot.sample.raw.acc);
+        ReinterpretCast(&dst.raw_mag, snapshot.sample.raw.mag);
+        dst.timestamp = snapshot.sample.timestamp;
+    }
+    *count = filled;
+}
+
+void __stdcall dkvrTrackerPredictOrientation(DKVRHostHandle handle, int index, long long timestamp, DKVRQuaternion* out)
+{
+    dkvr::Quaternionf predicted{};
+    DKVRHOST(handle)->PredictTrackerOrientation(index, timestamp, predicted);
+    ReinterpretCast(out, predicted);
+}
+void __stdcall dkvrTrackerPredictOrientationAll(DKVRHostHandle handle, long long timestamp, DKVRQuaternion* out, int capacity, int* count)
+{
+    static_assert(sizeof DKVRQuaternion == sizeof dkvr::Quaternionf);
+    *count = static_cast<int>(DKVRHOST(handle)->PredictTrackerOrientationAll(timestamp, reinterpret_cast<dkvr::Quaternionf*>(out), std::max(capacity, 0)));
+}
+
+void __stdcall dkvrTrackerGetSampleCursor(DKVRHostHandle handle, int index, unsigned long long* cursor) { *cursor = DKVRHOST(handle)->GetTrackerSampleCursor(index); }
+void __stdcall dkvrTrackerReadSamples(DKVRHostHandle handle, int index, unsigned long long* cursor, DKVRTimedSample* out, int capacity, int* count, unsigned long long* lost)
+{
+    uint64_t pos = *cursor;
+    uint64_t skipped = 0;
+    size_t read = DKVRHOST(handle)->ReadTrackerSamples(index, pos, reinterpret_cast<dkvr::TimedSample*>(out), std::max(capacity, 0), skipped);
+    *cursor = pos;
+    *count = static_cast<int>(read);
+    if (lost) *lost = skipped;
+}
+
 void __stdcall dkvrTrackerRequestLocate(DKVRHostHandle handle, int index)       { DKVRHOST(handle)->RequestTrackerLocate(index); }
 void __stdcall dkvrTrackerRequestStatus(DKVRHostHandle handle, int index)       { DKVRHOST(handle)->RequestTrackerStatus(index); }
 void __stdcall dkvrTrackerRequestStatistic(DKVRHostHandle handle, int index)    { DKVRHOST(handle)->RequestTrackerStatistic(index); }
 
+void __stdcall dkvrTrackerGetConfigSyncStat(DKVRHostHandle handle, int index, DKVRConfigSyncStat* out)
+{
+    dkvr::ConfigSyncStatistic stat = DKVRHOST(handle)->GetTrackerConfigSyncStatistic(index);
+    out->synced = stat.synced;
+    out->transmissions = stat.transmissions;
+    out->retransmissions = stat.retransmissions;
+    out->last_latency = stat.last_latency_ms;
+    out->max_latency = stat.max_latency_ms;
+}
+
+// pipeline latency
+void __stdcall dkvrStatsGetLatencyHistogram(DKVRHostHandle handle, int stage, DKVRLatencyHistogram* out)
+{
+    dkvr::LatencySnapshot snapshot = DKVRHOST(handle)->GetLatencySnapshot(stage);
+    out->count = snapshot.count;
+    out->min = snapshot.min;
+    out->max = snapshot.max;
+    out->mean = snapshot.mean();
+    out->p50 = snapshot.Percentile(0.5);
+    out->p90 = snapshot.Percentile(0.9);
+    out->p99 = snapshot.Percentile(0.99);
+    out->p999 = snapshot.Percentile(0.999);
+}
+void __stdcall dkvrStatsGetLatencyBuckets(DKVRHostHandle handle, int stage, unsigned long long* counts, long long* bounds, int capacity, int* count)
+{
+    dkvr::LatencySnapshot snapshot = DKVRHOST(handle)->GetLatencySnapshot(stage);
+    int written = 0;
+    for (size_t i = 0; i < dkvr::LatencySnapshot::kBucketCount && written < capacity; i++)
+    {
+        if (snapshot.buckets[i] == 0)
+            continue;
+        counts[written] = snapshot.buckets[i];
+        bounds[written] = dkvr::LatencySnapshot::BucketUpperBound(i);
+        written++;
+    }
+    *count = written;
+}
+void __stdcall dkvrStatsResetLatencyHistogram(DKVRHostHandle handle)                        { DKVRHOST(handle)->ResetLatency(); }
+
+// network counters
+void __stdcall dkvrStatsGetNetworkCounters(DKVRHostHandle handle, DKVRNetworkCounters* out)
+{
+    dkvr::UDPServer::TrafficStatistic traffic = DKVRHOST(handle)->GetTrafficStatistic();
+    dkvr::UDPServer::InvalidDatagramStatistic invalid = DKVRHOST(handle)->GetInvalidDatagramStatistic();
+    out->rx_packets = traffic.rx_packets;
+    out->rx_bytes = traffic.rx_bytes;
+    out->tx_packets = traffic.tx_packets;
+    out->tx_bytes = traffic.tx_bytes;
+    out->send_errors = traffic.send_errors;
+    out->received_dropped = DKVRHOST(handle)->GetReceivedDropped();
+    out->sending_dropped = DKVRHOST(handle)->GetSendingDropped();
+    out->invalid_truncated = invalid.truncated;
+    out->invalid_opener = invalid.wrong_opener;
+    out->invalid_length = invalid.wrong_length;
+    out->invalid_opcode = invalid.unknown_opcode;
+}
+void __stdcall dkvrStatsGetTrackerNetworkCountersAll(DKVRHostHandle handle, DKVRTrackerNetworkCounters* out, int capacity, int* count)
+{
+    static_assert(sizeof DKVRTrackerNetworkCounters == sizeof dkvr::TrackerNetworkCounters);
+    int filled = 0;
+    dkvr::TrackerNetworkCounters counters;
+    while (filled < capacity && DKVRHOST(handle)->GetTrackerNetworkCounters(filled, counters))
+        ReinterpretCast(&out[filled++], counters);
+    *count = filled;
+}
+void __stdcall dkvrStatsGetBatchStatistic(DKVRHostHandle handle, DKVRBatchStatistic* out)
+{
+    dkvr::UDPServer::BatchStatistic stat = DKVRHOST(handle)->GetBatchStatistic();
+    out->batch_size = static_cast<int>(stat.batch_size);
+    out->recv_calls = stat.recv_calls;
+    out->recv_datagrams = stat.recv_datagrams;
+    out->recv_full = stat.batch_size ? stat.recv_fill[stat.batch_size] : 0;
+    out->send_calls = stat.send_calls;
+    out->send_datagrams = stat.send_datagrams;
+    out->send_full = stat.batch_size ? stat.send_fill[stat.batch_size] : 0;
+}
+void __stdcall dkvrStatsGetBatchFill(DKVRHostHandle handle, int send, unsigned long long* fill, int capacity, int* count)
+{
+    dkvr::UDPServer::BatchStatistic stat = DKVRHOST(handle)->GetBatchStatistic();
+    const uint64_t* source = send ? stat.send_fill : stat.recv_fill;
+    int written = 0;
+    if (stat.batch_size)
+    {
+        for (; written <= static_cast<int>(stat.batch_size) && written < capacity; written++)
+            fill[written] = source[written];
+    }
+    *count = written;
+}
+
+// event tracing
+void __stdcall dkvrTraceStart(DKVRHostHandle handle)                                        { DKVRHOST(handle)->StartTrace(); }
+void __stdcall dkvrTraceStop(DKVRHostHandle handle)                                         { DKVRHOST(handle)->StopTrace(); }
+void __stdcall dkvrTraceIsRunning(DKVRHostHandle handle, int* running)                      { *running = DKVRHOST(handle)->IsTracing(); }
+void __stdcall dkvrTraceDump(DKVRHostHandle handle, const char* path, int* success)         { *success = path && DKVRHOST(handle)->DumpTrace(path); }
+
 // calibrator
 void __stdcall dkvrCalibratorGetStatus(DKVRHostHandle handle, int* out)                     { *out = static_cast<int>(DKVRHOST(handle)->GetCalibratorStatus()); }
 void __stdcall dkvrCalibratorGetSampleType(DKVRHostHandle handle, int* out)                 { *out = static_cast<int>(DKVRHOST(handle)->GetCalibratorSampleType()); }
@@ -338,3 +609,12 @@ void __stdcall dkvrCalibratorGetCurrentTarget(DKVRHostHandle handle, int* out)
 void __stdcall dkvrCalibratorBeginWith(DKVRHostHandle handle, int index)                    { DKVRHOST(handle)->BeginCalibrationWith(index); }
 void __stdcall dkvrCalibratorAbort(DKVRHostHandle handle)                                   { DKVRHOST(handle)->AbortCalibration(); }
 void __stdcall dkvrCalibratorContinue(DKVRHostHandle handle)                                { DKVRHOST(handle)->ContinueCalibration(); }
+
+// sample notification
+void __stdcall dkvrRegisterSampleCallback(DKVRHostHandle handle, DKVRSampleCallback callback, void* context)     { DKVRHOST(handle)->RegisterSampleCallback(callback, context); }
+void __stdcall dkvrWaitForSamples(DKVRHostHandle handle, int timeout_ms, unsigned long long mask, int* arrived)   { *arrived = DKVRHOST(handle)->WaitForSamples(timeout_ms, mask); }
+
+// pose publisher
+void __stdcall dkvrPosePublisherRun(DKVRHostHandle handle, const char* name, int* success)  { *success = DKVRHOST(handle)->RunPosePublisher(name ? name : ""); }
+void __stdcall dkvrPosePublisherStop(DKVRHostHandle handle)                                 { DKVRHOST(handle)->StopPosePublisher(); }
+void __stdcall dkvrPosePublisherIsRunning(DKVRHostHandle handle, int* running)              { *running = DKVRHOST(handle)->IsPosePublisherRunning(); }
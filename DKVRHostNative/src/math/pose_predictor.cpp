@@ -0,0 +1,110 @@
+#include "math/pose_predictor.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Eigen/Geometry"
+
+namespace dkvr {
+
+	namespace
+	{
+		// enough to find two nominal samples even when raw data is interleaved
+		constexpr size_t kHistoryWindow = 16;
+
+		Eigen::Quaternionf ToEigen(const Quaternionf& q)   { return Eigen::Quaternionf(q.w(), q.x(), q.y(), q.z()); }
+		Quaternionf FromEigen(const Eigen::Quaternionf& q) { return Quaternionf{ q.w(), q.x(), q.y(), q.z() }; }
+	}
+
+	bool PosePredictor::Predict(int index, int64_t timestamp, Quaternionf& out) const
+	{
+		NominalDataSet latest_data;
+		if (!tk_provider_.LoadNominalData(index, latest_data))
+			return false;
+
+		uint64_t head = tk_provider_.GetSampleCursor(index);
+		uint64_t cursor = head > kHistoryWindow ? head - kHistoryWindow : 0;
+		uint64_t lost = 0;
+		TimedSample window[kHistoryWindow];
+		size_t count = tk_provider_.ReadSamples(index, cursor, window, kHistoryWindow, lost);
+
+		// two latest nominal samples
+		const TimedSample* latest = nullptr;
+		const TimedSample* previous = nullptr;
+		for (size_t i = count; i > 0; i--)
+		{
+			if (window[i - 1].kind != SampleKind::Nominal)
+				continue;
+
+			if (latest == nullptr)
+			{
+				latest = &window[i - 1];
+			}
+			else
+			{
+				previous = &window[i - 1];
+				break;
+			}
+		}
+
+		if (latest == nullptr)
+		{
+			out = latest_data.orientation;
+			return true;
+		}
+
+		if (previous == nullptr || latest->timestamp <= previous->timestamp)
+		{
+			out = latest->nominal.orientation;
+			return true;
+		}
+
+		int64_t horizon = std::chrono::duration_cast<std::chrono::nanoseconds>(kMaxPredictionHorizon).count();
+		int64_t target = std::min(timestamp, latest->timestamp + horizon);
+		if (target <= previous->timestamp)
+		{
+			out = previous->nominal.orientation;
+			return true;
+		}
+
+		float t = static_cast<float>(target - previous->timestamp) / static_cast<float>(latest->timestamp - previous->timestamp);
+		if (t <= 1.0f)
+			out = Slerp(previous->nominal.orientation, latest->nominal.orientation, t);
+		else
+			out = Extrapolate(previous->nominal.orientation, latest->nominal.orientation, t);
+
+		return true;
+	}
+
+	size_t PosePredictor::PredictAll(int64_t timestamp, Quaternionf* out, size_t capacity) const
+	{
+		size_t count = 0;
+		while (count < capacity && Predict(static_cast<int>(count), timestamp, out[count]))
+			count++;
+
+		return count;
+	}
+
+	Quaternionf PosePredictor::Slerp(const Quaternionf& from, const Quaternionf& to, float t)
+	{
+		// Eigen takes the shortest path
+		return FromEigen(ToEigen(from).slerp(t, ToEigen(to)).normalized());
+	}
+
+	Quaternionf PosePredictor::Extrapolate(const Quaternionf& from, const Quaternionf& to, float t)
+	{
+		Eigen::Quaternionf q0 = ToEigen(from);
+		Eigen::Quaternionf q1 = ToEigen(to);
+
+		// body frame rotation between the samples, keep it on the shortest path
+		Eigen::Quaternionf delta = q0.conjugate() * q1;
+		if (delta.w() < 0.0f)
+			delta.coeffs() = -delta.coeffs();
+
+		// keep rotating with the same angular velocity for (t - 1) intervals
+		Eigen::AngleAxisf step(delta);
+		Eigen::Quaternionf rotation(Eigen::AngleAxisf(step.angle() * (t - 1.0f), step.axis()));
+		return FromEigen((q1 * rotation).normalized());
+	}
+
+}	// namespace dkvr
\ No newline at end of file
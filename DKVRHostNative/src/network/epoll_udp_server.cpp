@@ -0,0 +1,526 @@
+#ifdef __linux__
+
+#include "network/epoll_udp_server.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "tracker/tracker_data.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace dkvr
+{
+
+    namespace
+    {
+        // epoll_wait() must return periodically so ThreadContainer can observe its exit flag
+        constexpr int kEpollTimeoutMs = 100;
+        constexpr int kMaxEvents = 4;
+        constexpr int kInvalidFd = -1;
+    }
+
+    EpollUDPServer::EpollUDPServer(PipelineLatency& latency) :
+        epoll_thread_(*this, "epoll"),
+        socket_(kInvalidFd),
+        epoll_fd_(kInvalidFd),
+        wakeup_fd_(kInvalidFd),
+        socket_binded_(false),
+        write_interest_(false),
+        kernel_timestamp_(false),
+        recv_batch_{},
+        recv_addr_{},
+        recv_iov_{},
+        recv_msgs_{},
+        recv_control_{},
+        send_batch_{},
+        send_addr_{},
+        send_iov_{},
+        send_msgs_{},
+        send_begin_(0),
+        send_end_(0),
+        recv_fill_{},
+        send_fill_{},
+        latency_(latency)
+    {
+        PrepareBatch();
+        epoll_thread_ += &EpollUDPServer::SendAndRecvMessage;
+    }
+
+    EpollUDPServer::~EpollUDPServer()
+    {
+        InternalClose();
+    }
+
+    int EpollUDPServer::InternalInit()
+    {
+        // get local ip address
+        addrinfo hints{
+            .ai_flags = AI_PASSIVE,
+            .ai_family = AF_INET,
+            .ai_socktype = SOCK_DGRAM,
+            .ai_protocol = IPPROTO_UDP,
+        };
+        char hostname[256];
+        if (!gethostname(hostname, sizeof(hostname))) {
+            addrinfo* result = nullptr;
+            if (!getaddrinfo(hostname, std::to_string(host_port()).c_str(), &hints, &result)) {
+                for (addrinfo* ptr = result; ptr != nullptr; ptr = ptr->ai_next) {
+                    if (ptr->ai_family == AF_INET) {
+                        unsigned long ip = reinterpret_cast<sockaddr_in*>(ptr->ai_addr)->sin_addr.s_addr;
+                        unsigned char* ptr = reinterpret_cast<unsigned char*>(&ip);
+                        // will be logged if init successful
+                        logger_.Info("Host ip address is {:d}.{:d}.{:d}.{:d}", ptr[0], ptr[1], ptr[2], ptr[3]);
+                    }
+                }
+                freeaddrinfo(result);
+            }
+        }
+
+        // create epoll instance and wakeup event
+        // you cannot use logger here, just throw exception
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ == kInvalidFd)
+            throw std::runtime_error(Logger::FormatString("epoll creation failed : {}", std::strerror(errno)));
+
+        wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeup_fd_ == kInvalidFd) {
+            int error = errno;
+            close(epoll_fd_);
+            epoll_fd_ = kInvalidFd;
+            throw std::runtime_error(Logger::FormatString("eventfd creation failed : {}", std::strerror(error)));
+        }
+
+        epoll_event ev{ .events = EPOLLIN, .data = { .fd = wakeup_fd_ } };
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev);
+
+        // create socket
+        if (int error = CreateSocket()) {
+            close(wakeup_fd_);
+            close(epoll_fd_);
+            wakeup_fd_ = epoll_fd_ = kInvalidFd;
+            throw std::runtime_error(Logger::FormatString("Socket creation failed : {}", std::strerror(error)));
+        }
+
+        return 0;
+    }
+
+    int EpollUDPServer::InternalBind()
+    {
+        // a socket can be binded only once, recreate it for rebinding (error recovery)
+        if (socket_binded_) {
+            CloseSocket();
+            if (int error = CreateSocket()) {
+                logger_.Error("Socket creation failed : {}", error);
+                ParseSocketError(error);
+                return 1;
+            }
+        }
+
+        sockaddr_in server_addr{
+            .sin_family = AF_INET,
+            .sin_port = 0
+        };
+
+        // use specific IP and port if provided
+        // hostname commonly resolves to loopback(127.0.1.1) on Linux, so bind to any address by default
+        if (host_ip())
+            server_addr.sin_addr.s_addr = host_ip();
+        else
+            server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+        if (host_port())
+            server_addr.sin_port = htons(host_port());
+        else
+            server_addr.sin_port = htons(kDefaultHostPort);
+
+        if (bind(socket_, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr))) {
+            // socket bind failed
+            int error = errno;
+            logger_.Error("Socket binding failed : {}", error);
+            ParseSocketError(error);
+
+            return 1;
+        }
+        socket_binded_ = true;
+
+        // log host ip and port
+        set_host_ip(server_addr.sin_addr.s_addr);
+        set_host_port(ntohs(server_addr.sin_port));
+
+        unsigned char* ptr = reinterpret_cast<unsigned char*>(&server_addr.sin_addr.s_addr);
+        logger_.Info("Host is binded to {}.{}.{}.{}:{}", ptr[0], ptr[1], ptr[2], ptr[3], host_port());
+        if (!kernel_timestamp_)
+            logger_.Debug("Kernel receive timestamp is not available, datagrams are stamped by the epoll thread.");
+
+        // run net thread
+        epoll_thread_.Run();
+        logger_.Debug("Epoll network thread launched.");
+
+        return 0;
+    }
+
+    void EpollUDPServer::InternalClose()
+    {
+        if (!epoll_thread_.IsRunning())
+            return;
+
+        // cut the epoll_wait() short, thread will exit within kEpollTimeoutMs anyway
+        InternalNotifySending();
+        epoll_thread_.Stop();
+        logger_.Debug("Epoll network thread closed.");
+        LogBatchStatistic();
+    }
+
+    void EpollUDPServer::InternalDeinit()
+    {
+        InternalClose();
+        CloseSocket();
+        if (wakeup_fd_ != kInvalidFd)
+            close(wakeup_fd_);
+        if (epoll_fd_ != kInvalidFd)
+            close(epoll_fd_);
+        wakeup_fd_ = epoll_fd_ = kInvalidFd;
+    }
+
+    void EpollUDPServer::InternalNotifySending()
+    {
+        uint64_t one = 1;
+        if (wakeup_fd_ != kInvalidFd)
+            (void)write(wakeup_fd_, &one, sizeof(one));
+    }
+
+    int EpollUDPServer::CreateSocket()
+    {
+        socket_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+        if (socket_ == kInvalidFd)
+            return errno;
+
+        // kernel stamps every datagram on arrival, falls back to the time recvmmsg() returned if not supported
+        int enable = 1;
+        kernel_timestamp_ = setsockopt(socket_, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0;
+
+        epoll_event ev{ .events = EPOLLIN, .data = { .fd = socket_ } };
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_, &ev)) {
+            int error = errno;
+            close(socket_);
+            socket_ = kInvalidFd;
+            return error;
+        }
+
+        socket_binded_ = false;
+        write_interest_ = false;
+        return 0;
+    }
+
+    void EpollUDPServer::CloseSocket()
+    {
+        if (socket_ == kInvalidFd)
+            return;
+
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket_, nullptr);
+        close(socket_);
+        socket_ = kInvalidFd;
+        socket_binded_ = false;
+        send_begin_ = send_end_ = 0;
+    }
+
+    void EpollUDPServer::ParseSocketError(int error)
+    {
+        switch (error)
+        {
+        case ENETDOWN:
+            logger_.Error("Network is down.");
+            break;
+
+        case EMFILE:
+        case ENFILE:
+            // socket : no more file descriptor available
+            logger_.Error("No more socket available.");
+            break;
+
+        case ENOBUFS:
+        case ENOMEM:
+            logger_.Error("No buffer space available.");
+            break;
+
+        case EADDRINUSE:
+            logger_.Error("Current address already in use. Try with other port. Current port : {}", host_port());
+            break;
+
+        case EADDRNOTAVAIL:
+            logger_.Error("Requested address is not available on this host.");
+            break;
+
+        case ENETUNREACH:
+            // sendto : network is unreachable
+            logger_.Error("A socket operation was attempted to an unreachable network.");
+            break;
+
+        default:
+            logger_.Error("Unchecked socket error and can't be handled : {}", std::strerror(error));
+            break;
+        }
+    }
+
+    void EpollUDPServer::SendAndRecvMessage()
+    {
+        epoll_event events[kMaxEvents];
+        int count;
+        {
+            TraceScope scope(tracer_, "wait");
+            count = epoll_wait(epoll_fd_, events, kMaxEvents, kEpollTimeoutMs);
+        }
+        if (count < 0)
+        {
+            if (errno != EINTR)
+            {
+                int error = errno;
+                logger_.Error("epoll_wait failed : {}", error);
+                ParseSocketError(error);
+            }
+            return;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.fd == wakeup_fd_)
+            {
+                DrainWakeupEvent();
+                continue;
+            }
+
+            if (events[i].events & EPOLLIN)
+                HandleRecv();
+        }
+
+        // always try flushing, EPOLLOUT only matters after the kernel buffer was full
+        FlushSending();
+    }
+
+    void EpollUDPServer::PrepareBatch()
+    {
+        for (size_t i = 0; i < kBatchSize; i++)
+        {
+            recv_iov_[i] = iovec{ .iov_base = &recv_batch_[i].buffer, .iov_len = sizeof(Datagram::buffer) };
+            recv_msgs_[i] = mmsghdr{};
+            recv_msgs_[i].msg_hdr.msg_name = &recv_addr_[i];
+            recv_msgs_[i].msg_hdr.msg_iov = &recv_iov_[i];
+            recv_msgs_[i].msg_hdr.msg_iovlen = 1;
+            recv_msgs_[i].msg_hdr.msg_control = recv_control_[i];
+            recv_msgs_[i].msg_hdr.msg_controllen = sizeof(recv_control_[i]);
+
+            send_addr_[i] = sockaddr_in{ .sin_family = AF_INET };
+            send_iov_[i] = iovec{ .iov_base = &send_batch_[i].buffer, .iov_len = 0 };
+            send_msgs_[i] = mmsghdr{};
+            send_msgs_[i].msg_hdr.msg_name = &send_addr_[i];
+            send_msgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            send_msgs_[i].msg_hdr.msg_iov = &send_iov_[i];
+            send_msgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    void EpollUDPServer::HandleRecv()
+    {
+        TraceScope scope(tracer_, "HandleRecv");
+        // drain everything until EAGAIN so that one wakeup serves a whole burst
+        while (true)
+        {
+            // kernel overwrites msg_namelen and msg_controllen, reset them every call
+            for (size_t i = 0; i < kBatchSize; i++)
+            {
+                recv_msgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                recv_msgs_[i].msg_hdr.msg_controllen = sizeof(recv_control_[i]);
+            }
+
+            int count = recvmmsg(socket_, recv_msgs_, kBatchSize, MSG_DONTWAIT, nullptr);
+            if (count < 0)
+            {
+                int error = errno;
+                if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR)
+                    return;
+
+                logger_.Error("Network recvmmsg failed : {}", error);
+                ParseSocketError(error);
+                return;
+            }
+
+            // kernel timestamps are CLOCK_REALTIME, moved to steady_clock by the offset between both clocks right now
+            int64_t steady_now = SteadyTimestampNow();
+            timespec realtime{};
+            clock_gettime(CLOCK_REALTIME, &realtime);
+            int64_t realtime_offset = steady_now - (static_cast<int64_t>(realtime.tv_sec) * 1'000'000'000 + realtime.tv_nsec);
+
+            // invalid datagrams are dropped and the valid ones are packed to the front
+            size_t valid = 0;
+            for (int i = 0; i < count; i++)
+            {
+                // buffers are reused, clear the bytes previous datagram left behind
+                char* buffer = reinterpret_cast<char*>(&recv_batch_[i].buffer);
+                size_t len = recv_msgs_[i].msg_len;
+                if (len < sizeof(Datagram::buffer))
+                    std::memset(buffer + len, 0, sizeof(Datagram::buffer) - len);
+
+                recv_batch_[i].address = recv_addr_[i].sin_addr.s_addr;
+                recv_batch_[i].timestamp.received = ReceiveTimestamp(recv_msgs_[i].msg_hdr, steady_now, realtime_offset);
+                // datagram larger than Instruction is cut to the buffer, its length byte may still look valid
+                bool truncated = (recv_msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+                if (!ValidateReceived(recv_batch_[i], len, truncated))
+                    continue;
+
+                if (valid != static_cast<size_t>(i))
+                    recv_batch_[valid] = recv_batch_[i];
+                valid++;
+            }
+
+            int64_t queued = SteadyTimestampNow();
+            for (size_t i = 0; i < valid; i++)
+            {
+                recv_batch_[i].timestamp.queued = queued;
+                if (kernel_timestamp_)
+                    latency_.Record(PipelineLatency::kNetworkRecorder, LatencyStage::KernelToReceive, steady_now - recv_batch_[i].timestamp.received);
+            }
+            latency_.Record(PipelineLatency::kNetworkRecorder, LatencyStage::ReceiveToQueue, queued - steady_now, valid);
+            tracer_.Counter("recvmmsg batch", count);
+            PushReceived(recv_batch_, valid);
+            recv_fill_[count].fetch_add(1, std::memory_order_relaxed);
+
+            // partially filled batch means socket is drained
+            if (static_cast<size_t>(count) < kBatchSize)
+                return;
+        }
+    }
+
+    int64_t EpollUDPServer::ReceiveTimestamp(const msghdr& msg, int64_t steady_now, int64_t realtime_offset) const
+    {
+        if (!kernel_timestamp_)
+            return steady_now;
+
+        for (const cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), const_cast<cmsghdr*>(cmsg)))
+        {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS)
+                continue;
+
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            int64_t timestamp = static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec + realtime_offset;
+
+            // realtime clock may be stepped between arrival and now, a datagram never arrives in the future
+            return timestamp < steady_now ? timestamp : steady_now;
+        }
+        return steady_now;
+    }
+
+    void EpollUDPServer::FlushSending()
+    {
+        TraceScope scope(tracer_, "FlushSending");
+        while (true)
+        {
+            // refill the batch once everything in it has been sent
+            if (send_begin_ == send_end_)
+            {
+                send_begin_ = 0;
+                send_end_ = PopSending(send_batch_, kBatchSize);
+                if (send_end_ == 0)
+                {
+                    SetWriteInterest(false);
+                    return;
+                }
+
+                for (size_t i = 0; i < send_end_; i++)
+                {
+                    send_addr_[i].sin_port = htons(client_port());
+                    send_addr_[i].sin_addr.s_addr = static_cast<in_addr_t>(send_batch_[i].address);
+                    send_iov_[i].iov_len = send_batch_[i].buffer.length + 8;   // payload length + header length
+                }
+            }
+
+            size_t remain = send_end_ - send_begin_;
+            int count = sendmmsg(socket_, send_msgs_ + send_begin_, static_cast<unsigned int>(remain), 0);
+            if (count < 0)
+            {
+                int error = errno;
+                if (error == EAGAIN || error == EWOULDBLOCK)
+                {
+                    // kernel buffer is full, hold the rest and wait for EPOLLOUT
+                    SetWriteInterest(true);
+                    return;
+                }
+
+                // error belongs to the first datagram, drop it and go on
+                logger_.Error("Network sendmmsg failed : {}", error);
+                ParseSocketError(error);
+                CountSendError();
+                send_begin_++;
+                continue;
+            }
+
+            // msg_len of each sent message receives the bytes actually sent
+            size_t bytes = 0;
+            for (size_t i = send_begin_; i < send_begin_ + count; i++)
+                bytes += send_msgs_[i].msg_len;
+            CountSent(bytes, static_cast<size_t>(count));
+            send_fill_[count].fetch_add(1, std::memory_order_relaxed);
+            send_begin_ += count;
+        }
+    }
+
+    void EpollUDPServer::SetWriteInterest(bool enable)
+    {
+        if (write_interest_ == enable)
+            return;
+
+        epoll_event ev{ .events = EPOLLIN | (enable ? EPOLLOUT : 0u), .data = { .fd = socket_ } };
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket_, &ev);
+        write_interest_ = enable;
+    }
+
+    void EpollUDPServer::DrainWakeupEvent()
+    {
+        uint64_t count;
+        while (read(wakeup_fd_, &count, sizeof(count)) > 0);
+    }
+
+    EpollUDPServer::BatchStatistic EpollUDPServer::batch_statistic() const
+    {
+        BatchStatistic stat{};
+        stat.batch_size = kBatchSize;
+        for (size_t i = 0; i <= kBatchSize; i++)
+        {
+            stat.recv_fill[i] = recv_fill_[i].load(std::memory_order_relaxed);
+            stat.send_fill[i] = send_fill_[i].load(std::memory_order_relaxed);
+
+            // empty call doesn't count as a batch
+            if (i == 0) continue;
+            stat.recv_calls += stat.recv_fill[i];
+            stat.recv_datagrams += stat.recv_fill[i] * i;
+            stat.send_calls += stat.send_fill[i];
+            stat.send_datagrams += stat.send_fill[i] * i;
+        }
+        return stat;
+    }
+
+    void EpollUDPServer::LogBatchStatistic() const
+    {
+        BatchStatistic stat = batch_statistic();
+        double recv_avg = stat.recv_calls ? static_cast<double>(stat.recv_datagrams) / stat.recv_calls : 0.0;
+        double send_avg = stat.send_calls ? static_cast<double>(stat.send_datagrams) / stat.send_calls : 0.0;
+
+        logger_.Debug("Epoll recv batch : {} datagrams / {} calls (avg fill {:.2f}/{}, full {})",
+            stat.recv_datagrams, stat.recv_calls, recv_avg, kBatchSize, stat.recv_fill[kBatchSize]);
+        logger_.Debug("Epoll send batch : {} datagrams / {} calls (avg fill {:.2f}/{}, full {})",
+            stat.send_datagrams, stat.send_calls, send_avg, kBatchSize, stat.send_fill[kBatchSize]);
+    }
+
+}	// namespace dkvr
+
+#endif  // #ifdef __linux__
\ No newline at end of file
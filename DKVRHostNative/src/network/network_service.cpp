@@ -5,8 +5,12 @@
 #include <stdexcept>
 #include <thread>
 
+#include "tracker/tracker_data.h"
+
 #ifdef _WIN32
 #	include "network/winsock2_udp_server.h"
+#elif defined(__linux__)
+#	include "network/epoll_udp_server.h"
 #else
 #	error "Include UDP Server header here."
 #endif
@@ -60,15 +64,17 @@ namespace dkvr
         bool IsPowerOf2(uint8_t num) { return !(num & (num - 1)); }
     }
 
-    NetworkService::NetworkService() :
+    NetworkService::NetworkService(PipelineLatency& latency, size_t receive_shards) :
         udp_(
 #ifdef _WIN32
-            std::make_unique<Winsock2UDPServer>()
+            std::make_unique<Winsock2UDPServer>(latency)
+#elif defined(__linux__)
+            std::make_unique<EpollUDPServer>(latency)
 #endif
         ),
-        watchdog_thread_(*this)
+        watchdog_thread_(*this, "network watchdog")
     {
-        if (udp_->Init())
+        if (udp_->Init(receive_shards))
             throw std::runtime_error("UDP server init failed with unknown reason.");
 
         watchdog_thread_ += &NetworkService::CheckAndRepairService;
@@ -101,25 +107,31 @@ namespace dkvr
         logger_.Debug("UDP server watchdog closed.");
     }
 
-    bool NetworkService::WaitAndPopReceived(unsigned long& address_out, Instruction& inst_out)
+    bool NetworkService::WaitAndPopReceived(unsigned long& address_out, Instruction& inst_out, DatagramTimestamp& timestamp_out, size_t shard)
     {
-        if (udp_->WaitReceived())
+        if (udp_->WaitReceived(shard))
         {
-            Datagram dgram = udp_->PopReceived();
+            Datagram dgram = udp_->PopReceived(shard);
             address_out = dgram.address;
             inst_out = dgram.buffer;
+            timestamp_out = dgram.timestamp;
+            timestamp_out.popped = SteadyTimestampNow();
             DoBitConversionIfRequired(inst_out);
             return true;
         }
         return false;
     }
 
-    void NetworkService::Send(unsigned long address, Instruction& inst)
+    bool NetworkService::Send(unsigned long address, Instruction& inst)
     {
         Datagram dgram{ address, inst };
         DoBitConversionIfRequired(dgram.buffer);
-        if (udp_->PushSending(dgram))
+        int result = udp_->PushSending(dgram);
+        if (result == 1)
             logger_.Error("[Network Service] Instruction queuing failed : internal UDP Server not binded.");
+        else if (result)
+            logger_.Error("[Network Service] Instruction dropped : sending queue is full ({} dropped so far).", udp_->sending_dropped());
+        return result == 0;
     }
 
     // UDP server watchdog
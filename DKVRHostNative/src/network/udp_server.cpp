@@ -1,10 +1,18 @@
 #include "network/udp_server.h"
 
+#include <algorithm>
+#include <cstddef>
+
+#include "instruction/instruction_set.h"
+
 namespace dkvr 
 {
 
-	int UDPServer::Init()
+	int UDPServer::Init(size_t shard_count)
 	{
+		shard_count_ = std::clamp<size_t>(shard_count, 1, kMaxReceiveShards);
+		shards_ = std::make_unique<ReceivedShard[]>(shard_count_);
+
 		int result = InternalInit();
 
 		// InitFailed status is meaningless as NetworkService will just throw if result is non-zero
@@ -58,13 +66,7 @@ namespace dkvr
 
 	void UDPServer::Close()
 	{
-		convar_.notify_all();
-		{
-			// actually volatile keyword is not needed but just a little protection for compiler optimization
-			// tested at Compiler Explorer for MSVC v19 with '-O2' and GCC 14.2 with '-O3'
-			// generate same code with or without volatile
-			volatile std::lock_guard<std::mutex> lock(mutex_);
-		}
+		Wakeup();
 		InternalClose();
 		status_ = Status::StandBy;
 	}
@@ -83,72 +85,187 @@ namespace dkvr
 			return 1;
 		}
 
-		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			sending_.push(dgram);
-		}
+		if (!sending_.Push(dgram))
+			return 2;	// sending queue overflow
+
+		InternalNotifySending();
 		return 0;
 	}
 
 	bool UDPServer::PeekSending() const
 	{
-		bool available;
-		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			available = !sending_.empty();
-		}
-		return available;
+		return !sending_.Empty();
 	}
 
 	Datagram UDPServer::PopSending()
 	{
-		Datagram result;
-		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			result = sending_.front();
-			sending_.pop();
-		}
+		Datagram result{};
+		sending_.TryPop(result);
 		return result;
 	}
 
+	size_t UDPServer::PopSending(Datagram* out, size_t max)
+	{
+		size_t count = 0;
+		while (count < max && sending_.TryPop(out[count]))
+			count++;
+		return count;
+	}
+
+	bool UDPServer::ValidateReceived(const Datagram& dgram, size_t size, bool truncated)
+	{
+		rx_packets_.fetch_add(1, std::memory_order_relaxed);
+		rx_bytes_.fetch_add(size, std::memory_order_relaxed);
+
+		std::atomic_uint64_t* counter = nullptr;
+		const Instruction& inst = dgram.buffer;
+		if (size < kInstructionHeaderSize)
+			counter = &invalid_truncated_;
+		else if (inst.opener != kOpenerValue)
+			counter = &invalid_opener_;
+		else if (truncated || inst.length > size - kInstructionHeaderSize)
+			counter = &invalid_length_;
+		else if ((inst.opcode & InstructionSet::kOpcodeClassMask) > InstructionSet::kClassDataTransfer)
+			counter = &invalid_opcode_;
+		else
+			return true;
+
+		counter->fetch_add(1, std::memory_order_relaxed);
+
+		unsigned long address = dgram.address;
+		unsigned char* ip = reinterpret_cast<unsigned char*>(&address);
+		logger_.Debug(
+			invalid_log_limit_, address,
+			"Invalid datagram({} bytes) dropped from {:d}.{:d}.{:d}.{:d}",
+			size, ip[0], ip[1], ip[2], ip[3]
+		);
+		return false;
+	}
+
 	void UDPServer::PushReceived(const Datagram& dgram)
 	{
+		ReceivedShard& shard = shards_[ShardOf(dgram.address)];
+		shard.queue.Push(dgram);
+		NotifyConsumerIfParked(shard);
+	}
+
+	void UDPServer::PushReceived(const Datagram* dgrams, size_t count)
+	{
+		static_assert(kMaxReceiveShards <= 32);
+
+		uint32_t touched = 0;
+		for (size_t i = 0; i < count; i++)
 		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			received_.push(dgram);
+			size_t index = ShardOf(dgrams[i].address);
+			shards_[index].queue.Push(dgrams[i]);
+			touched |= 1u << index;
 		}
-		convar_.notify_one();
+
+		for (size_t index = 0; touched; index++, touched >>= 1)
+			if (touched & 1u)
+				NotifyConsumerIfParked(shards_[index]);
+	}
+
+	bool UDPServer::PeekReceived(size_t shard) const
+	{
+		return !shards_[shard].queue.Empty();
 	}
 
-	bool UDPServer::PeekReceived() const
+	bool UDPServer::WaitReceived(size_t index) const
 	{
-		bool available;
+		const ReceivedShard& shard = shards_[index];
+		if (!shard.queue.Empty())
+			return true;
+
+		std::unique_lock<std::mutex> lock(shard.mutex);
+		shard.consumer_parked.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// re-check after announcing the park, producer may have pushed in between
+		// wakeup requested before parking is not lost either
+		if (shard.queue.Empty() && !shard.wakeup_requested)
+			shard.convar.wait(lock);
+
+		shard.wakeup_requested = false;
+		shard.consumer_parked.store(false, std::memory_order_relaxed);
+		return !shard.queue.Empty();
+	}
+
+	Datagram UDPServer::PopReceived(size_t shard)
+	{
+		Datagram result{};
+		shards_[shard].queue.TryPop(result);
+		return result;
+	}
+
+	void UDPServer::Wakeup()
+	{
+		for (size_t index = 0; index < shard_count_; index++)
 		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			available = !received_.empty();
+			const ReceivedShard& shard = shards_[index];
+			{
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				shard.wakeup_requested = true;
+			}
+			shard.convar.notify_all();
 		}
-		return available;
 	}
 
-	bool UDPServer::WaitReceived() const
+	size_t UDPServer::ShardOf(unsigned long address) const
 	{
-		std::unique_lock<std::mutex> lock(mutex_);
-		if (received_.empty()) {
-			convar_.wait(lock);
-			return !received_.empty();
-		}
-		return true;
+		if (shard_count_ == 1)
+			return 0;
+
+		// fibonacci hashing, then map the 32-bit hash onto [0, shard_count_) without division
+		uint32_t hash = static_cast<uint32_t>(address) * 2654435769u;
+		return static_cast<size_t>((static_cast<uint64_t>(hash) * shard_count_) >> 32);
+	}
+
+	uint64_t UDPServer::received_dropped() const
+	{
+		uint64_t dropped = 0;
+		for (size_t index = 0; index < shard_count_; index++)
+			dropped += shards_[index].queue.dropped();
+		return dropped;
+	}
+
+	UDPServer::InvalidDatagramStatistic UDPServer::invalid_statistic() const
+	{
+		return InvalidDatagramStatistic
+		{
+			.truncated = invalid_truncated_.load(std::memory_order_relaxed),
+			.wrong_opener = invalid_opener_.load(std::memory_order_relaxed),
+			.wrong_length = invalid_length_.load(std::memory_order_relaxed),
+			.unknown_opcode = invalid_opcode_.load(std::memory_order_relaxed)
+		};
+	}
+
+	UDPServer::TrafficStatistic UDPServer::traffic_statistic() const
+	{
+		return TrafficStatistic
+		{
+			.rx_packets = rx_packets_.load(std::memory_order_relaxed),
+			.rx_bytes = rx_bytes_.load(std::memory_order_relaxed),
+			.tx_packets = tx_packets_.load(std::memory_order_relaxed),
+			.tx_bytes = tx_bytes_.load(std::memory_order_relaxed),
+			.send_errors = send_errors_.load(std::memory_order_relaxed)
+		};
 	}
 
-	Datagram UDPServer::PopReceived()
+	void UDPServer::Wakeup(const ReceivedShard& shard)
 	{
-		Datagram result;
 		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			result = received_.front();
-			received_.pop();
+			std::lock_guard<std::mutex> lock(shard.mutex);
 		}
-		return result;
+		shard.convar.notify_all();
+	}
+
+	void UDPServer::NotifyConsumerIfParked(const ReceivedShard& shard)
+	{
+		// pairs with consumer_parked.store() in WaitReceived()
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (shard.consumer_parked.load(std::memory_order_relaxed))
+			Wakeup(shard);
 	}
 
 }	// namespace dkvr
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <sstream>
 #include <thread>
 
+#include "tracker/tracker_data.h"
+
 #include <WinSock2.h>
 #include <WS2tcpip.h>
 #pragma comment(lib, "Ws2_32.lib")
@@ -18,11 +20,12 @@ namespace dkvr
         constexpr TIMEVAL kTimeout{ 0, 0 };
     }
 
-    Winsock2UDPServer::Winsock2UDPServer() :
-        winsock_thread_(*this),
+    Winsock2UDPServer::Winsock2UDPServer(PipelineLatency& latency) :
+        winsock_thread_(*this, "winsock"),
         wsa_data_{},
         socket_(INVALID_SOCKET),
-        binding_ip_(0) 
+        binding_ip_(0),
+        latency_(latency)
     {
         winsock_thread_ += &Winsock2UDPServer::SendAndRecvMessage;
     }
@@ -210,6 +213,7 @@ namespace dkvr
 
     void Winsock2UDPServer::HandleRecv()
     {
+        TraceScope scope(tracer_, "HandleRecv");
         Datagram dgram{};
         sockaddr_in sender{};
         int sockaddr_size = sizeof sockaddr_in;
@@ -219,12 +223,27 @@ namespace dkvr
         if (res == SOCKET_ERROR) 
         {
             int error = WSAGetLastError();
+            if (error == WSAEMSGSIZE)
+            {
+                // datagram larger than Instruction, buffer holds its head only
+                dgram.address = sender.sin_addr.s_addr;
+                ValidateReceived(dgram, sizeof Datagram::buffer, true);
+                return;
+            }
+
             logger_.Error("Network recvfrom failed : {}", error);
             ParseWSAError(error);
             return;
         }
+        // winsock has no receive timestamp without WSARecvMsg, take it on the network thread before queueing
         dgram.address = sender.sin_addr.s_addr;
-        PushReceived(dgram);
+        dgram.timestamp.received = SteadyTimestampNow();
+        if (ValidateReceived(dgram, static_cast<size_t>(res)))
+        {
+            dgram.timestamp.queued = SteadyTimestampNow();
+            latency_.Record(PipelineLatency::kNetworkRecorder, LatencyStage::ReceiveToQueue, dgram.timestamp.queued - dgram.timestamp.received);
+            PushReceived(dgram);
+        }
     }
 
     bool Winsock2UDPServer::PeekWritability() const
@@ -239,6 +258,7 @@ namespace dkvr
 
     void Winsock2UDPServer::SendOneDatagram()
     {
+        TraceScope scope(tracer_, "SendOneDatagram");
         static sockaddr_in dst{
             .sin_family = AF_INET,
             .sin_port = htons(client_port())
@@ -256,7 +276,10 @@ namespace dkvr
             int error = WSAGetLastError();
             logger_.Error("Network sendto failed : {}", error);
             ParseWSAError(error);
+            CountSendError();
+            return;
         }
+        CountSent(static_cast<size_t>(res));
     }
 
 }	// namespace dkvr
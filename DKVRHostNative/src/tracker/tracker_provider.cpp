@@ -1,7 +1,5 @@
 #include "tracker/tracker_provider.h"
 
-#include <algorithm>
-#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -12,76 +10,167 @@ namespace dkvr {
 
 	TrackerProvider::~TrackerProvider()
 	{
-		for (TrackerMutexPair& p : trackers_)
+		for (size_t i = 0; i < slots_.size(); i++)
 		{
-			std::lock_guard<std::mutex> lock(*p.second);
+			std::lock_guard<std::mutex> lock(slots_[i].mutex);
 		}
 	}
 
-	AtomicTracker TrackerProvider::FindExistOrInsertNew(unsigned long address)
+	AtomicTracker TrackerProvider::FindExistOrInsertNew(unsigned long address, int* index)
 	{
+		TraceScope scope(tracer_, "TrackerProvider::FindExistOrInsertNew");
+		TrackerSlot* target;
 		{
 			std::lock_guard<std::mutex> lock(mutex_);
-			auto iter = std::find_if(
-				trackers_.begin(),
-				trackers_.end(),
-				[address](const TrackerMutexPair& item) {
-					return item.first.address() == address;
-				}
-			);
-			if (iter != trackers_.end())
-				return AtomicTracker(&iter->first, iter->second);
+			auto iter = address_index_.find(address);
+			if (iter != address_index_.end())
+			{
+				if (index) *index = static_cast<int>(iter->second);
+				target = &slots_[iter->second];
+			}
+			else
+			{
+				if (index) *index = static_cast<int>(slots_.size());
+				target = InternalAddTracker(address);
+			}
+		}
+
+		return Lock(target);
+	}
+
+	AtomicTracker TrackerProvider::FindByAddress(unsigned long address, int* index)
+	{
+		TraceScope scope(tracer_, "TrackerProvider::FindByAddress");
+		TrackerSlot* target;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto iter = address_index_.find(address);
+			if (iter == address_index_.end())
+				return AtomicTracker();
+
+			if (index) *index = static_cast<int>(iter->second);
+			target = &slots_[iter->second];
 		}
-		return InternalAddTracker(address);
+
+		return Lock(target);
 	}
 
 	AtomicTracker TrackerProvider::FindByIndex(int index)
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
+		TraceScope scope(tracer_, "TrackerProvider::FindByIndex");
+		TrackerSlot* target;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (index < 0 || index >= slots_.size())
+				return AtomicTracker();
 
-		if (index < 0 || index >= trackers_.size())
-			return AtomicTracker();
+			target = &slots_[index];
+		}
 
-		TrackerMutexPair& target = trackers_.at(index);
-		return AtomicTracker(&target.first, target.second);
+		return Lock(target);
 	}
 
 	ConstAtomicTracker TrackerProvider::FindByIndex(int index) const
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
+		TraceScope scope(tracer_, "TrackerProvider::FindByIndex");
+		const TrackerSlot* target;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (index < 0 || index >= slots_.size())
+				return ConstAtomicTracker();
 
-		if (index < 0 || index >= trackers_.size())
-			return ConstAtomicTracker();
+			target = &slots_[index];
+		}
 
-		const TrackerMutexPair& target = trackers_.at(index);
-		return ConstAtomicTracker(&target.first, target.second);
+		return ConstAtomicTracker(&target->tracker, target->mutex);
 	}
 
 	AtomicTracker TrackerProvider::FindByName(std::string name)
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
-
-		for (auto i = trackers_.begin(); i != trackers_.end(); i++)
+		TraceScope scope(tracer_, "TrackerProvider::FindByName");
+		unsigned long address;
 		{
-			if (i->first.name() == name)
-				return AtomicTracker(&i->first, i->second);
+			std::lock_guard<std::mutex> lock(name_mutex_);
+			auto iter = name_index_.find(name);
+			if (iter == name_index_.end())
+				return AtomicTracker();
+			address = iter->second;
 		}
-		return AtomicTracker();
+
+		return FindByAddress(address);
 	}
 
 	std::vector<AtomicTracker> TrackerProvider::GetAllTrackers()
 	{
+		size_t count = GetCount();
 		std::vector<AtomicTracker> v;
-		std::lock_guard<std::mutex> lock(mutex_);
-		for (TrackerMutexPair& p : trackers_)
-			v.emplace_back(&p.first, p.second);
+		v.reserve(count);
+		for (size_t i = 0; i < count; i++)
+			v.push_back(Lock(&slots_[i]));
 		return v;
 	}
 
+	bool TrackerProvider::LoadRawData(int index, RawDataSet& out) const
+	{
+		// slots below size() are fully constructed and never move
+		if (index < 0 || index >= slots_.size())
+			return false;
+
+		out = slots_[index].tracker.raw_data();
+		return true;
+	}
+
+	bool TrackerProvider::LoadNominalData(int index, NominalDataSet& out) const
+	{
+		if (index < 0 || index >= slots_.size())
+			return false;
+
+		out = slots_[index].tracker.nominal_data();
+		return true;
+	}
+
+	bool TrackerProvider::LoadSnapshot(int index, TrackerSnapshot& out) const
+	{
+		if (index < 0 || index >= slots_.size())
+			return false;
+
+		// address never changes and connection status is atomic
+		const Tracker& target = slots_[index].tracker;
+		out.address = target.address();
+		out.connection = target.connection_status();
+		out.sample = target.sample();
+		return true;
+	}
+
+	bool TrackerProvider::LoadNetworkCounters(int index, TrackerNetworkCounters& out) const
+	{
+		if (index < 0 || index >= slots_.size())
+			return false;
+
+		out = slots_[index].tracker.network_counters();
+		return true;
+	}
+
+	size_t TrackerProvider::ReadSamples(int index, uint64_t& cursor, TimedSample* out, size_t max, uint64_t& lost) const
+	{
+		if (index < 0 || index >= slots_.size())
+			return 0;
+
+		return slots_[index].tracker.history().ReadSince(cursor, out, max, lost);
+	}
+
+	uint64_t TrackerProvider::GetSampleCursor(int index) const
+	{
+		if (index < 0 || index >= slots_.size())
+			return 0;
+
+		return slots_[index].tracker.history().head();
+	}
+
 	size_t TrackerProvider::GetCount() const
 	{
 		std::lock_guard<std::mutex> lock(mutex_);
-		return trackers_.size();
+		return slots_.size();
 	}
 
 	size_t TrackerProvider::GetIndexOf(const Tracker* target)
@@ -89,27 +178,55 @@ namespace dkvr {
 		if (target == nullptr)
 			return -1;
 
-		size_t index = 0;
 		std::lock_guard<std::mutex> lock(mutex_);
-		for (TrackerMutexPair& pair : trackers_)
+		auto iter = address_index_.find(target->address());
+		return iter != address_index_.end() ? iter->second : -1;
+	}
+
+	void TrackerProvider::UpdateName(unsigned long address, const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(name_mutex_);
+
+		std::string& current = names_[address];
+		if (current == name)
+			return;
+
+		// release the old name, hand it over to another tracker with the same name if any
+		auto iter = name_index_.find(current);
+		if (iter != name_index_.end() && iter->second == address)
 		{
-			if (pair.first.address() == target->address())
-				return index;
-			index++;
+			name_index_.erase(iter);
+			for (const auto& [other, other_name] : names_)
+			{
+				if (other != address && other_name == current)
+				{
+					name_index_.emplace(current, other);
+					break;
+				}
+			}
 		}
-		return -1;
+
+		current = name;
+		name_index_.emplace(name, address);
 	}
 
-	AtomicTracker TrackerProvider::InternalAddTracker(unsigned long address)
+	TrackerProvider::TrackerSlot* TrackerProvider::InternalAddTracker(unsigned long address)
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
-		trackers_.emplace_back(Tracker(address), std::make_shared<std::mutex>());
-		TrackerMutexPair& last = trackers_.back();
+		if (slots_.Full())
+		{
+			logger_.Error("Tracker storage is full, {} trackers at most.", slots_.kCapacity);
+			return nullptr;
+		}
+
+		// constructed in place, existing slots and the trackers being held by others are not touched
+		TrackerSlot& last = slots_.Emplace(address);
+		address_index_.emplace(address, slots_.size() - 1);
+		UpdateName(address, last.tracker.name());
 #ifdef DKVR_DEBUG_TRACKER_CONNECTION_DETAIL
 		unsigned char* ptr = reinterpret_cast<unsigned char*>(&address);
 		logger_.Debug("Tracker added with ip {:d}.{:d}.{:d}.{:d}", ptr[0], ptr[1], ptr[2], ptr[3]);
 #endif
-		return AtomicTracker(&last.first, last.second);
+		return &last;
 	}
 
 }	// namespace dkvr
\ No newline at end of file
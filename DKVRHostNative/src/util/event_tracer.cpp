@@ -0,0 +1,197 @@
+#include "util/event_tracer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "fmt/format.h"
+
+namespace dkvr
+{
+
+    namespace
+    {
+        thread_local std::string thread_name;
+
+        double Microseconds(int64_t nanoseconds) { return nanoseconds / 1000.0; }
+    }
+
+    thread_local EventTracer::ThreadSlot EventTracer::thread_slot_;
+
+    EventTracer::ThreadSlot::~ThreadSlot()
+    {
+        if (events)
+            GetInstance().ReleaseThreadEvents(events);
+    }
+
+    EventTracer& EventTracer::GetInstance()
+    {
+        static EventTracer instance;
+        return instance;
+    }
+
+    EventTracer::EventTracer() :
+        enabled_(false),
+        start_(0),
+        threads_(std::make_unique<ThreadEvents[]>(kMaxThreads)),
+        thread_count_(0),
+        free_slots_(),
+        untraced_count_(0),
+        slot_mutex_()
+    {
+        free_slots_.reserve(kMaxThreads);
+    }
+
+    void EventTracer::SetThreadName(const std::string& name)
+    {
+        thread_name = name;
+        if (thread_slot_.events)
+        {
+            EventTracer& tracer = GetInstance();
+            std::lock_guard<std::mutex> lock(tracer.slot_mutex_);
+            thread_slot_.events->name = name;
+        }
+    }
+
+    void EventTracer::Start()
+    {
+        start_.store(Now(), std::memory_order_relaxed);
+        enabled_.store(true, std::memory_order_release);
+    }
+
+    void EventTracer::Stop()
+    {
+        enabled_.store(false, std::memory_order_release);
+    }
+
+    void EventTracer::Record(Phase phase, const char* name, int64_t timestamp, int64_t value)
+    {
+        ThreadEvents* events = thread_slot_.events;
+        if (!events)
+        {
+            events = AcquireThreadEvents();
+            if (!events)
+                return;
+        }
+
+        uint64_t head = events->head.load(std::memory_order_relaxed);
+        events->events[head & (kEventsPerThread - 1)] = Event{ timestamp, value, name, phase };
+        events->head.store(head + 1, std::memory_order_release);
+    }
+
+    EventTracer::ThreadEvents* EventTracer::AcquireThreadEvents()
+    {
+        if (thread_slot_.untraced)
+            return nullptr;
+
+        // slot is taken on the first event, threads never traced never take one
+        std::lock_guard<std::mutex> lock(slot_mutex_);
+        size_t slot;
+        if (!free_slots_.empty())
+        {
+            // ring is kept, events of the previous owner are dropped from the dump from here on
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            ThreadEvents& events = threads_[slot];
+            events.first.store(events.head.load(std::memory_order_relaxed), std::memory_order_release);
+        }
+        else
+        {
+            slot = thread_count_.load(std::memory_order_relaxed);
+            if (slot >= kMaxThreads)
+            {
+                thread_slot_.untraced = true;
+                untraced_count_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            threads_[slot].events = std::make_unique<Event[]>(kEventsPerThread);
+            thread_count_.store(slot + 1, std::memory_order_release);
+        }
+
+        ThreadEvents& events = threads_[slot];
+        events.name = thread_name.empty() ? fmt::format("thread {}", slot) : thread_name;
+        thread_slot_.events = &events;
+        return &events;
+    }
+
+    void EventTracer::ReleaseThreadEvents(ThreadEvents* events)
+    {
+        // events and name stay in the dump until another thread takes the slot
+        std::lock_guard<std::mutex> lock(slot_mutex_);
+        free_slots_.push_back(static_cast<size_t>(events - threads_.get()));
+    }
+
+    bool EventTracer::Dump(const std::string& path) const
+    {
+        static_assert((kEventsPerThread & (kEventsPerThread - 1)) == 0);
+
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file)
+            return false;
+
+        int64_t start = start_.load(std::memory_order_relaxed);
+        size_t count = thread_count_.load(std::memory_order_acquire);
+
+        fmt::memory_buffer out;
+        fmt::format_to(fmt::appender(out), "{{\"displayTimeUnit\":\"ns\",\"otherData\":{{\"untraced_threads\":{}}},\"traceEvents\":[\n",
+            UntracedThreads());
+        fmt::format_to(fmt::appender(out), "{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{{\"name\":\"DKVRHost\"}}}}");
+
+        std::vector<Event> copied(kEventsPerThread);
+        for (size_t tid = 0; tid < count; tid++)
+        {
+            const ThreadEvents& events = threads_[tid];
+            uint64_t first;
+            {
+                std::lock_guard<std::mutex> lock(slot_mutex_);
+                first = events.first.load(std::memory_order_acquire);
+                fmt::format_to(fmt::appender(out), ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}", tid, events.name);
+            }
+
+            uint64_t end = events.head.load(std::memory_order_acquire);
+            uint64_t begin = end > kEventsPerThread ? end - kEventsPerThread : 0;
+            for (uint64_t i = begin; i < end; i++)
+                copied[i - begin] = events.events[i & (kEventsPerThread - 1)];
+
+            // the writer may be overwriting one more entry than it has published
+            uint64_t after = events.head.load(std::memory_order_acquire);
+            uint64_t intact = after + 1 > kEventsPerThread ? after + 1 - kEventsPerThread : 0;
+
+            // slot changed hands during the copy, events of the new owner would carry the old name
+            uint64_t reused = events.first.load(std::memory_order_acquire);
+            if (reused != first)
+                end = std::min(end, reused);
+
+            for (uint64_t i = std::max({ begin, intact, first }); i < end; i++)
+            {
+                const Event& event = copied[i - begin];
+                if (event.timestamp < start)
+                    continue;
+
+                double ts = Microseconds(event.timestamp - start);
+                switch (event.phase)
+                {
+                case Phase::Complete:
+                    fmt::format_to(fmt::appender(out), ",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                        event.name, tid, ts, Microseconds(event.value));
+                    break;
+
+                case Phase::Counter:
+                    fmt::format_to(fmt::appender(out), ",\n{{\"name\":\"{}\",\"ph\":\"C\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"args\":{{\"value\":{}}}}}",
+                        event.name, tid, ts, event.value);
+                    break;
+
+                case Phase::Instant:
+                    fmt::format_to(fmt::appender(out), ",\n{{\"name\":\"{}\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":{},\"ts\":{:.3f}}}",
+                        event.name, tid, ts);
+                    break;
+                }
+            }
+        }
+        fmt::format_to(fmt::appender(out), "\n]}}\n");
+
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        return static_cast<bool>(file);
+    }
+
+}   // namespace dkvr
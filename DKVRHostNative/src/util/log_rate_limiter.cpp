@@ -0,0 +1,100 @@
+#include "util/log_rate_limiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+#include "util/logger.h"
+
+namespace dkvr {
+
+	LogRateLimiter::LogRateLimiter(double rate_per_second, double burst) :
+		mutex_(),
+		entries_{},
+		rate_(rate_per_second),
+		burst_(std::max(burst, 1.0))
+	{
+		Logger::GetInstance().RegisterLimiter(this);
+	}
+
+	LogRateLimiter::~LogRateLimiter()
+	{
+		Logger::GetInstance().UnregisterLimiter(this);
+	}
+
+	bool LogRateLimiter::Admit(uint64_t key, LogRecord& record)
+	{
+		int64_t now = Now();
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		Entry& entry = FindOrEvict(key, now);
+		double elapsed = static_cast<double>(now - entry.last_seen) / 1e9;
+		entry.tokens = std::min(burst_, entry.tokens + elapsed * rate_);
+		entry.last_seen = now;
+
+		if (entry.tokens < 1.0)
+		{
+			entry.suppressed++;
+			entry.last = record;
+			return false;
+		}
+
+		entry.tokens -= 1.0;
+		if (entry.suppressed)
+		{
+			record.fold = LogFold::Suppressed;
+			record.repeated = entry.suppressed;
+			entry.suppressed = 0;
+		}
+		return true;
+	}
+
+	size_t LogRateLimiter::Sweep(int64_t now, LogRecord* out, size_t max)
+	{
+		int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(kFoldInterval).count();
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		size_t count = 0;
+		for (Entry& entry : entries_)
+		{
+			if (count >= max)
+				break;
+			if (!entry.used || entry.suppressed == 0 || now - entry.last_seen < interval)
+				continue;
+
+			out[count] = entry.last;
+			out[count].fold = LogFold::Repeated;
+			out[count].repeated = entry.suppressed;
+			entry.suppressed = 0;
+			count++;
+		}
+		return count;
+	}
+
+	LogRateLimiter::Entry& LogRateLimiter::FindOrEvict(uint64_t key, int64_t now)
+	{
+		Entry* victim = &entries_[0];
+		for (Entry& entry : entries_)
+		{
+			if (entry.used && entry.key == key)
+				return entry;
+
+			// buckets are taken in order and never released
+			if (!entry.used)
+			{
+				victim = &entry;
+				break;
+			}
+			if (entry.last_seen < victim->last_seen)
+				victim = &entry;
+		}
+
+		victim->used = true;
+		victim->key = key;
+		victim->tokens = burst_;
+		victim->last_seen = now;
+		victim->suppressed = 0;
+		return *victim;
+	}
+
+}	// namespace dkvr
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include "util/logger.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <string_view>
+#include <thread>
 
 namespace dkvr {
 
@@ -33,51 +36,282 @@ namespace dkvr {
 		return instance;
 	}
 
-	Logger::Logger() : mutex_(), unchecked_(), out_(&std::cout), level_(Level::Info), mode_(Mode::Burst) { }
+	Logger::Logger() :
+		mutex_(),
+		unchecked_(kDefaultUncheckedCapacity),
+		out_(&std::cout),
+		level_(Level::Info),
+		mode_(Mode::Burst),
+		ring_(),
+		formatter_(*this),
+		formatter_mutex_(),
+		formatter_refs_(0),
+		formatter_active_(false),
+		submitting_(0),
+		submitted_(0),
+		processed_(0),
+		idle_mutex_(),
+		idle_cv_(),
+		processed_mutex_(),
+		processed_cv_(),
+		limiters_mutex_(),
+		limiters_(),
+		batch_buffer_(),
+		batch_ends_(),
+		time_cache_(),
+		reported_dropped_(0),
+		last_sweep_(0)
+	{
+		batch_ends_.reserve(kFormatBatchSize + 1);
+		formatter_ += &Logger::FormatterLoop;
+	}
 
 	Logger::~Logger()
 	{
-
+		// output stream may be gone already, pending records are discarded
+		formatter_active_ = false;
+		formatter_.Stop();
 	}
 
 	int Logger::GetUncheckedCount() const
 	{
+		Flush();
 		std::lock_guard<std::mutex> lock(mutex_);
 		return unchecked_.size();
 	}
 
 	void Logger::PrintUnchecked()
 	{
-		PrintUnchecked(unchecked_.size());
+		PrintUnchecked(std::numeric_limits<std::size_t>::max());
 	}
 
 	void Logger::PrintUnchecked(std::size_t count)
 	{
+		Flush();
 		std::lock_guard<std::mutex> lock(mutex_);
 
 		if (unchecked_.size() < count)
 			count = unchecked_.size();
 
-		for (std::size_t i = 0; i < count; i++) {
-			std::string& str = unchecked_.front();
-			*out_ << str << std::endl;
-			unchecked_.pop();
+		std::string_view first, second;
+		for (std::size_t i = 0; i < count && unchecked_.Front(first, second); i++) {
+			*out_ << first << second << std::endl;
+			unchecked_.Pop();
+		}
+	}
+
+	Logger& Logger::operator<< (const std::string& str)
+	{
+		if (str.size() <= kMaxRawRecordSize)
+		{
+			Enqueue(Level::Error, false, "{}", str);
+			return *this;
+		}
+
+		if (mode_ == Mode::Silent)
+			return *this;
+
+		// record would truncate it, queued lines are written first to keep the order
+		Flush();
+		fmt::memory_buffer buffer;
+		buffer.append(str.data(), str.data() + str.size());
+		size_t end = buffer.size();
+		Write(buffer, std::span<const size_t>(&end, 1));
+		return *this;
+	}
+
+	void Logger::StartFormatter()
+	{
+		std::lock_guard<std::mutex> lock(formatter_mutex_);
+		if (formatter_refs_++ > 0)
+			return;
+
+		formatter_.Run();
+		formatter_active_ = true;
+	}
+
+	void Logger::StopFormatter()
+	{
+		std::lock_guard<std::mutex> lock(formatter_mutex_);
+		if (formatter_refs_ == 0 || --formatter_refs_ > 0)
+			return;
+
+		// later records are written synchronously
+		formatter_active_ = false;
+		idle_cv_.notify_all();
+		NotifyProcessed();
+		formatter_.Stop();
+
+		// producers which saw the formatter active may still be pushing
+		while (submitting_.load() > 0)
+			std::this_thread::yield();
+
+		// records pushed before the switch
+		while (Drain(kFormatBatchSize) > 0);
+	}
+
+	void Logger::Flush() const
+	{
+		uint64_t target = submitted_.load();
+		if (!formatter_active_ || processed_.load() >= target)
+			return;
+
+		// formatter may be sleeping out its idle wait
+		idle_cv_.notify_all();
+
+		std::unique_lock<std::mutex> lock(processed_mutex_);
+		processed_cv_.wait(lock, [this, target] { return !formatter_active_ || processed_.load() >= target; });
+	}
+
+	void Logger::NotifyProcessed() const
+	{
+		// waiter checks its predicate under the mutex, taking it here keeps the notify from slipping in between
+		{ std::lock_guard<std::mutex> lock(processed_mutex_); }
+		processed_cv_.notify_all();
+	}
+
+	uint64_t Logger::dropped() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return ring_.dropped() + unchecked_.dropped();
+	}
+
+	void Logger::set_ostream(std::ostream& ostream)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		out_ = &ostream;
+	}
+
+	void Logger::set_unchecked_capacity(size_t capacity)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		unchecked_.Reset(capacity);
+	}
+
+	void Logger::Submit(const LogRecord& record)
+	{
+		if (formatter_active_)
+		{
+			// announce before checking again, StopFormatter() waits for the push before its final drain
+			submitting_.fetch_add(1);
+			if (formatter_active_)
+			{
+				// never blocks, dropped records are reported by the formatter
+				if (ring_.Push(record))
+					submitted_.fetch_add(1, std::memory_order_relaxed);
+				submitting_.fetch_sub(1);
+				return;
+			}
+			submitting_.fetch_sub(1);
+		}
+
+		fmt::memory_buffer buffer;
+		TimeCache cache;
+		FormatRecord(record, buffer, cache);
+		size_t end = buffer.size();
+		Write(buffer, std::span<const size_t>(&end, 1));
+	}
+
+	void Logger::RegisterLimiter(LogRateLimiter* limiter)
+	{
+		std::lock_guard<std::mutex> lock(limiters_mutex_);
+		limiters_.push_back(limiter);
+	}
+
+	void Logger::UnregisterLimiter(LogRateLimiter* limiter)
+	{
+		std::lock_guard<std::mutex> lock(limiters_mutex_);
+		limiters_.erase(std::remove(limiters_.begin(), limiters_.end(), limiter), limiters_.end());
+	}
+
+	void Logger::SweepLimiters()
+	{
+		int64_t now = LogRateLimiter::Now();
+		if (now - last_sweep_ < std::chrono::duration_cast<std::chrono::nanoseconds>(kLimiterSweepInterval).count())
+			return;
+		last_sweep_ = now;
+
+		std::lock_guard<std::mutex> lock(limiters_mutex_);
+		LogRecord folded[LogRateLimiter::kMaxKeys];
+		for (LogRateLimiter* limiter : limiters_)
+		{
+			size_t count = limiter->Sweep(now, folded, LogRateLimiter::kMaxKeys);
+			for (size_t i = 0; i < count; i++)
+				Submit(folded[i]);
+		}
+	}
+
+	void Logger::FormatterLoop()
+	{
+		SweepLimiters();
+		if (Drain(kFormatBatchSize) > 0)
+			return;
+
+		std::unique_lock<std::mutex> lock(idle_mutex_);
+		idle_cv_.wait_for(lock, kFormatterIdleWait);
+	}
+
+	size_t Logger::Drain(size_t max)
+	{
+		batch_buffer_.clear();
+		batch_ends_.clear();
+		ReportDropped(batch_buffer_, batch_ends_);
+
+		size_t count = 0;
+		LogRecord record;
+		while (count < max && ring_.TryPop(record))
+		{
+			FormatRecord(record, batch_buffer_, time_cache_);
+			batch_ends_.push_back(batch_buffer_.size());
+			count++;
+		}
+
+		if (!batch_ends_.empty())
+			Write(batch_buffer_, batch_ends_);
+		if (count > 0)
+		{
+			processed_.fetch_add(count, std::memory_order_relaxed);
+			NotifyProcessed();
 		}
+
+		return count;
+	}
+
+	void Logger::ReportDropped(fmt::memory_buffer& buffer, std::vector<size_t>& ends)
+	{
+		uint64_t dropped = ring_.dropped();
+		if (dropped == reported_dropped_)
+			return;
+
+		int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		FormatPrefix(Level::Error, now, buffer, time_cache_);
+		fmt::format_to(fmt::appender(buffer), "{} log records dropped.", dropped - reported_dropped_);
+		ends.push_back(buffer.size());
+		reported_dropped_ = dropped;
 	}
 
-	void Logger::Push(std::string&& str)
+	void Logger::Write(const fmt::memory_buffer& buffer, std::span<const size_t> ends)
 	{
 		std::lock_guard<std::mutex> lock(mutex_);
 
+		size_t begin = 0;
 		switch (mode_)
 		{
 		case Logger::Mode::Echo:
-			(*out_) << str << std::endl;
+			for (size_t end : ends) {
+				out_->write(buffer.data() + begin, end - begin);
+				out_->put('\n');
+				begin = end;
+			}
+			out_->flush();
 			break;
 
 		default:
 		case Logger::Mode::Burst:
-			unchecked_.emplace(std::move(str));
+			for (size_t end : ends) {
+				unchecked_.Push(std::string_view(buffer.data() + begin, end - begin));
+				begin = end;
+			}
 			break;
 
 		case Logger::Mode::Silent:
@@ -85,24 +319,48 @@ namespace dkvr {
 		}
 	}
 
-	void Logger::Push(const std::string& str)
+	void Logger::FormatRecord(const LogRecord& record, fmt::memory_buffer& out, TimeCache& cache)
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
+		if (record.prefixed)
+			FormatPrefix(static_cast<Level>(record.level), record.timestamp, out, cache);
+		record.format(record, out);
 
-		switch (mode_)
+		switch (record.fold)
 		{
-		case Logger::Mode::Echo:
-			(*out_) << str << std::endl;
+		case LogFold::Suppressed:
+			fmt::format_to(fmt::appender(out), " ({} similar messages suppressed)", record.repeated);
 			break;
 
-		default:
-		case Logger::Mode::Burst:
-			unchecked_.push(str);
+		case LogFold::Repeated:
+			fmt::format_to(fmt::appender(out), " (last message repeated {} times)", record.repeated);
 			break;
 
-		case Logger::Mode::Silent:
+		default:
 			break;
 		}
 	}
 
+	void Logger::FormatPrefix(Level level, int64_t timestamp, fmt::memory_buffer& out, TimeCache& cache)
+	{
+		int64_t second = timestamp / 1000000000;
+		if (second != cache.second)
+		{
+			auto end = fmt::format_to_n(cache.text, sizeof cache.text, "{:%Y-%m-%d %H:%M:%S}", fmt::localtime(static_cast<std::time_t>(second)));
+			cache.size = end.size;
+			cache.second = second;
+		}
+
+		std::string_view tag;
+		switch (level)
+		{
+		case Level::Error:	tag = "[ERROR] "; break;
+		case Level::Info:	tag = "[INFO] ";  break;
+		default:
+		case Level::Debug:	tag = "[DEBUG] "; break;
+		}
+		out.append(tag.data(), tag.data() + tag.size());
+		out.append(cache.text, cache.text + cache.size);
+		out.push_back('\t');
+	}
+
 }	// namespace dkvr
\ No newline at end of file
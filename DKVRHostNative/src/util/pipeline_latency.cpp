@@ -0,0 +1,36 @@
+#include "util/pipeline_latency.h"
+
+#include <limits>
+
+namespace dkvr
+{
+
+    PipelineLatency::PipelineLatency() :
+        recorders_(std::make_unique<RecorderHistograms[]>(kRecorderCount))
+    { }
+
+    LatencySnapshot PipelineLatency::Snapshot(LatencyStage stage) const
+    {
+        LatencySnapshot snapshot{};
+        snapshot.min = std::numeric_limits<int64_t>::max();
+
+        size_t index = static_cast<size_t>(stage);
+        if (index < kStageCount)
+        {
+            for (size_t i = 0; i < kRecorderCount; i++)
+                recorders_[i].stages[index].MergeInto(snapshot);
+        }
+
+        if (snapshot.count == 0)
+            snapshot.min = 0;
+        return snapshot;
+    }
+
+    void PipelineLatency::Reset()
+    {
+        for (size_t i = 0; i < kRecorderCount; i++)
+            for (LatencyHistogram& histogram : recorders_[i].stages)
+                histogram.Reset();
+    }
+
+}   // namespace dkvr
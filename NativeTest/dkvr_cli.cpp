@@ -12,6 +12,8 @@ namespace
 {
     constexpr int kInvalidInt = -1;
     constexpr float kRadToDeg = (180.0f / 3.1415926535f);
+    // screen and ypr.dat are refreshed at most this often, samples may arrive much faster
+    constexpr std::chrono::milliseconds kImuReadFrameInterval(10);
 
     template <typename T>
     consteval T InvalidValue() { return T(-1); }
@@ -106,6 +108,9 @@ namespace dkvr
         if (debug)
         {
             callbacks_.emplace("statistic", &DKVRCLI::Statistic);
+            callbacks_.emplace("latency", &DKVRCLI::Latency);
+            callbacks_.emplace("traffic", &DKVRCLI::Traffic);
+            callbacks_.emplace("trace", &DKVRCLI::Trace);
             callbacks_.emplace("behavior", &DKVRCLI::Behavior);
             callbacks_.emplace("imu", &DKVRCLI::Imu);
             callbacks_.emplace("show", &DKVRCLI::Show);
@@ -211,12 +216,25 @@ namespace dkvr
     void DKVRCLI::UpdateImuRead()
     {
         // invalid target or calibrator is running
-        if (imu_read_target_ == -1 || calibrator_active_)
+        int target = imu_read_target_;
+        if (target < 0 || calibrator_active_)
         {
             std::this_thread::sleep_for(std::chrono::milliseconds(1000));
             return;
         }
 
+        // wake up on new samples of the target, timeout keeps the loop responsive to target change
+        int arrived;
+        dkvrWaitForSamples(handle_, 100, 1ULL << std::min(target, 63), &arrived);
+        if (!arrived)
+            return;
+
+        // keep the first sample of an idle period immediate, later ones wait for the next frame and read the latest data
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now < imu_read_next_frame_)
+            std::this_thread::sleep_until(imu_read_next_frame_);
+        imu_read_next_frame_ = std::max(now, imu_read_next_frame_) + kImuReadFrameInterval;
+
         DKVRVector3 vec3[5]{};
         DKVRQuaternion quat;
         if (show[0])    dkvrTrackerGetRawGyro(handle_, imu_read_target_, &vec3[0]);
@@ -334,9 +352,6 @@ namespace dkvr
                 fout.close();
             }
         }
-        
-        // delay
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 
     // DKVR functions
@@ -355,6 +370,9 @@ namespace dkvr
         {
             std::cout << '\n';
             std::cout << "statistic [index?]" << '\n';
+            std::cout << "latency [reset?]" << '\n';
+            std::cout << "traffic" << '\n';
+            std::cout << "trace [start/stop/dump] [path?]" << '\n';
             std::cout << "behavior [index] [led? active? raw? nominal?]" << '\n';
             std::cout << "imu read [index]" << '\n';
             std::cout << "imu stop" << '\n';
@@ -533,6 +551,141 @@ namespace dkvr
         }
     }
 
+    void DKVRCLI::Latency()
+    {
+        if (TestArgsCount(1) && !args_[1].compare("reset"))
+        {
+            dkvrStatsResetLatencyHistogram(handle_);
+            std::cout << "Latency histograms cleared." << std::endl;
+            return;
+        }
+
+        constexpr const char* kStageNames[LatencyStageCount] = {
+            "kernel -> recv", "recv -> queue", "queue -> pop", "pop -> dispatch",
+            "dispatch -> lock", "lock -> publish", "kernel -> publish"
+        };
+        auto us = [](long long ns) { return ns / 1000.0; };
+
+        std::cout   << std::setw(18) << "stage (us)        " << "| "
+                    << std::setw(10) << "count " << "| "
+                    << std::setw(9) << "p50 " << "| "
+                    << std::setw(9) << "p99 " << "| "
+                    << std::setw(9) << "p99.9 " << "| "
+                    << std::setw(9) << "max " << "\n"
+                    << "-------------------------------------------------------------------------"
+                    << std::endl;
+        for (int stage = 0; stage < LatencyStageCount; stage++)
+        {
+            DKVRLatencyHistogram histogram{};
+            dkvrStatsGetLatencyHistogram(handle_, stage, &histogram);
+
+            std::stringstream ss;
+            ss  << std::left << std::setw(18) << kStageNames[stage] << std::right << "| "
+                << std::setw(9) << histogram.count << " | "
+                << std::setprecision(1) << std::fixed
+                << std::setw(8) << us(histogram.p50) << " | "
+                << std::setw(8) << us(histogram.p99) << " | "
+                << std::setw(8) << us(histogram.p999) << " | "
+                << std::setw(8) << us(histogram.max);
+            std::cout << ss.str() << std::endl;
+        }
+    }
+
+    void DKVRCLI::Traffic()
+    {
+        DKVRNetworkCounters total{};
+        dkvrStatsGetNetworkCounters(handle_, &total);
+        std::cout   << "rx " << total.rx_packets << " packets / " << total.rx_bytes << " bytes, "
+                    << "tx " << total.tx_packets << " packets / " << total.tx_bytes << " bytes\n"
+                    << "dropped : recv queue " << total.received_dropped << ", send queue " << total.sending_dropped
+                    << ", send error " << total.send_errors << "\n"
+                    << "invalid : truncated " << total.invalid_truncated << ", opener " << total.invalid_opener
+                    << ", length " << total.invalid_length << ", opcode " << total.invalid_opcode
+                    << std::endl;
+
+        // batch fill of recvmmsg/sendmmsg, servers without batching report batch_size 0
+        DKVRBatchStatistic batch{};
+        dkvrStatsGetBatchStatistic(handle_, &batch);
+        if (batch.batch_size > 0)
+        {
+            double recv_avg = batch.recv_calls ? static_cast<double>(batch.recv_datagrams) / batch.recv_calls : 0.0;
+            double send_avg = batch.send_calls ? static_cast<double>(batch.send_datagrams) / batch.send_calls : 0.0;
+            std::stringstream ss;
+            ss  << std::setprecision(2) << std::fixed
+                << "batch   : recv avg fill " << recv_avg << "/" << batch.batch_size << " (" << batch.recv_full << " full of " << batch.recv_calls << " calls), "
+                << "send avg fill " << send_avg << "/" << batch.batch_size << " (" << batch.send_full << " full of " << batch.send_calls << " calls)";
+            std::cout << ss.str() << std::endl;
+        }
+        std::cout << std::endl;
+
+        constexpr int kCapacity = 64;
+        DKVRTrackerNetworkCounters counters[kCapacity];
+        int count = 0;
+        dkvrStatsGetTrackerNetworkCountersAll(handle_, counters, kCapacity, &count);
+
+        std::cout   << std::setw(2) << "# " << "| "
+                    << std::setw(10) << "rx pkt " << "| "
+                    << std::setw(10) << "tx pkt " << "| "
+                    << std::setw(8) << "late " << "| "
+                    << std::setw(8) << "lost " << "| "
+                    << std::setw(7) << "loss % " << "\n"
+                    << "------------------------------------------------------------"
+                    << std::endl;
+        for (int i = 0; i < count; i++)
+        {
+            const DKVRTrackerNetworkCounters& c = counters[i];
+            unsigned long long expected = c.rx_packets + c.sequence_gaps;
+            double loss = expected ? 100.0 * c.sequence_gaps / expected : 0.0;
+
+            std::stringstream ss;
+            ss  << std::setw(2) << i << "| "
+                << std::setw(9) << c.rx_packets << " | "
+                << std::setw(9) << c.tx_packets << " | "
+                << std::setw(7) << c.late_discards << " | "
+                << std::setw(7) << c.sequence_gaps << " | "
+                << std::setprecision(2) << std::fixed
+                << std::setw(6) << loss;
+            std::cout << ss.str() << std::endl;
+        }
+    }
+
+    void DKVRCLI::Trace()
+    {
+        if (!TestArgsCount(1))
+        {
+            int running;
+            dkvrTraceIsRunning(handle_, &running);
+            std::cout << "Event tracing is " << (running ? "running." : "stopped.") << std::endl;
+            return;
+        }
+
+        std::string& command = args_[1];
+        if (!command.compare("start"))
+        {
+            dkvrTraceStart(handle_);
+            std::cout << "Event tracing started." << std::endl;
+        }
+        else if (!command.compare("stop"))
+        {
+            dkvrTraceStop(handle_);
+            std::cout << "Event tracing stopped." << std::endl;
+        }
+        else if (!command.compare("dump"))
+        {
+            std::string path = TestArgsCount(2) ? args_[2] : "dkvr_trace.json";
+            int success;
+            dkvrTraceDump(handle_, path.c_str(), &success);
+            if (success)
+                std::cout << "Trace written to " << path << std::endl;
+            else
+                std::cout << "Failed to write " << path << std::endl;
+        }
+        else
+        {
+            std::cout << "Unknown argument : " << command << std::endl;
+        }
+    }
+
     void DKVRCLI::Behavior()
     {
         if (!TestArgsCount(1))
@@ -606,7 +759,7 @@ namespace dkvr
             
             int count;
             dkvrTrackerGetCount(handle_, &count);
-            if (target >= count)
+            if (target < 0 || target >= count)
             {
                 std::cout << "Index out of range." << std::endl;
                 return;
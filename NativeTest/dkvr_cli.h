@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <iostream>
 #include <map>
 #include <thread>
@@ -37,6 +38,9 @@ namespace dkvr
         void Locate();
 
         void Statistic();
+        void Latency();
+        void Traffic();
+        void Trace();
         void Behavior();
         void Imu();
         void Show();
@@ -62,6 +66,7 @@ namespace dkvr
         std::atomic_bool show[3]{};
         std::atomic_bool show2[3]{};
         std::atomic_bool ypr_export = false;
+        std::chrono::steady_clock::time_point imu_read_next_frame_{};     // imu reader thread only
 
         // calibrator variables
         std::atomic_bool calibrator_active_ = false;
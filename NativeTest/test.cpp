@@ -2,6 +2,175 @@
 
 #include "dkvr_cli.h"
 
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include "instruction/compact_nominal.h"
+#include "instruction/instruction_set.h"
+#include "util/timer_wheel.h"
+
+// decode cost and bytes on air of float Nominal against protocol v3 NominalCompact
+TEST(CompactNominal, DecodeBenchmark)
+{
+    using namespace dkvr;
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t kSamples = 1 << 16;
+    constexpr int kRounds = 32;
+
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> dist;
+    std::vector<NominalDataSet> source(kSamples);
+    for (NominalDataSet& data : source)
+    {
+        for (int i = 0; i < 4; i++) data.orientation[i] = dist(rng);
+        for (int i = 0; i < 3; i++) data.linear_acceleration[i] = dist(rng) * 4.0f;
+        for (int i = 0; i < 3; i++) data.magnetic_disturbance[i] = dist(rng) * 16.0f;
+    }
+
+    std::vector<uint8_t> full(kSamples * sizeof(NominalDataSet));
+    std::vector<uint8_t> compact(kSamples * kCompactSampleSize);
+    for (size_t i = 0; i < kSamples; i++)
+    {
+        memcpy(&full[i * sizeof(NominalDataSet)], &source[i], sizeof(NominalDataSet));
+        CompactNominal::Encode(source[i], &compact[i * kCompactSampleSize + sizeof(uint16_t)]);
+    }
+
+    std::vector<NominalDataSet> decoded(kSamples);
+    auto measure = [&](auto&& decode)
+        {
+            Clock::time_point begin = Clock::now();
+            for (int round = 0; round < kRounds; round++)
+                decode();
+            return std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / (kSamples * kRounds);
+        };
+
+    double float_ns = measure([&]()
+        {
+            for (size_t i = 0; i < kSamples; i++)
+                memcpy(&decoded[i], &full[i * sizeof(NominalDataSet)], sizeof(NominalDataSet));
+        });
+    double scalar_ns = measure([&]()
+        {
+            for (size_t i = 0; i < kSamples; i++)
+                CompactNominal::Decode(&compact[i * kCompactSampleSize + sizeof(uint16_t)], decoded[i]);
+        });
+    double batch_ns = measure([&]()
+        {
+            // one frame at most carries kMaxCompactSamples, decode in the same chunks the handler does
+            for (size_t i = 0; i < kSamples; i += kMaxCompactSamples)
+            {
+                size_t count = std::min(kMaxCompactSamples, kSamples - i);
+                CompactNominal::DecodeBatch(&compact[i * kCompactSampleSize + sizeof(uint16_t)], kCompactSampleSize, count, &decoded[i]);
+            }
+        });
+
+    // decoded orientation must be the same rotation, fixed point within half a step
+    for (size_t i = 0; i < kSamples; i++)
+    {
+        const Quaternionf& q = source[i].orientation;
+        float norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        float dot = 0;
+        for (int k = 0; k < 4; k++)
+            dot += q[k] / norm * decoded[i].orientation[k];
+        ASSERT_GT(std::fabs(dot), 1.0f - 1e-6f);
+        for (int k = 0; k < 3; k++)
+        {
+            ASSERT_NEAR(decoded[i].linear_acceleration[k], source[i].linear_acceleration[k], CompactNominal::kLinearAccelerationScale);
+            ASSERT_NEAR(decoded[i].magnetic_disturbance[k], source[i].magnetic_disturbance[k], CompactNominal::kMagneticDisturbanceScale);
+        }
+    }
+
+    // IPv4 and UDP header, instruction header, payload
+    constexpr size_t kFrameOverhead = 20 + 8 + 8;
+    size_t nominal_bytes = kFrameOverhead + sizeof(NominalDataSet);
+    size_t batch_bytes = kFrameOverhead + sizeof(SampleBatchHeader) + kMaxBatchSamples<NominalDataSet> * sizeof(BatchedSample<NominalDataSet>);
+    size_t compact_bytes = kFrameOverhead + sizeof(uint8_t) + kMaxCompactSamples * kCompactSampleSize;
+
+    std::cout << "decode ns/sample   float " << float_ns << " / compact " << scalar_ns << " / compact batch " << batch_ns << '\n';
+    std::cout << "bytes/sample       Nominal " << nominal_bytes
+        << " / NominalBatch " << static_cast<double>(batch_bytes) / kMaxBatchSamples<NominalDataSet>
+        << " / NominalCompact " << static_cast<double>(compact_bytes) / kMaxCompactSamples << '\n';
+}
+
+// random deadlines on every level (and past the range), each must expire on its own tick, never early
+// NextDeadline() must stay ahead of the wheel so stepping to it never skips a timer
+TEST(TimerWheel, RandomDeadlines)
+{
+    using namespace dkvr;
+    using Clock = TimerWheel::Clock;
+
+    constexpr size_t kTimers = 512;
+    constexpr int64_t kTickNs = std::chrono::duration_cast<std::chrono::nanoseconds>(TimerWheel::kTick).count();
+
+    std::mt19937_64 rng(5678);
+    Clock::time_point origin(std::chrono::hours(1));
+    Clock::time_point now = origin;
+    TimerWheel wheel(origin);
+
+    // delta within [64^level, 64^(level + 1)) ticks, level kLevels is up to twice the range and gets clamped
+    auto random_deadline = [&](Clock::time_point from, size_t max_level)
+        {
+            size_t level = std::uniform_int_distribution<size_t>(0, max_level)(rng);
+            int64_t low = level == 0 ? 0 : int64_t(1) << (TimerWheel::kSlotBits * level);
+            int64_t high = level == TimerWheel::kLevels ? 2 * low : int64_t(1) << (TimerWheel::kSlotBits * (level + 1));
+            int64_t ticks = std::uniform_int_distribution<int64_t>(low, high - 1)(rng);
+            int64_t fraction = std::uniform_int_distribution<int64_t>(0, kTickNs - 1)(rng);
+            return from + std::chrono::nanoseconds(ticks * kTickNs + fraction);
+        };
+
+    std::vector<TimerWheel::Timer> timers(kTimers);
+    std::vector<Clock::time_point> deadlines(kTimers);
+    std::vector<bool> rearmed(kTimers, false);
+    for (size_t i = 0; i < kTimers; i++)
+    {
+        timers[i].id = static_cast<uint32_t>(i);
+        deadlines[i] = random_deadline(now, TimerWheel::kLevels);
+        wheel.Schedule(timers[i], deadlines[i]);
+    }
+
+    size_t fired = 0;
+    while (!wheel.Empty())
+    {
+        Clock::time_point next = wheel.NextDeadline();
+        ASSERT_GT(next, now);
+
+        // land on the deadline or somewhere before it, so Advance() also runs between slot boundaries
+        if (std::uniform_int_distribution<int>(0, 3)(rng) == 0)
+            now += std::chrono::nanoseconds(std::uniform_int_distribution<int64_t>(1, (next - now).count())(rng));
+        else
+            now = next;
+
+        wheel.Advance(now, [&](TimerWheel::Timer& timer)
+            {
+                ASSERT_FALSE(timer.armed);
+                ASSERT_GE(now, deadlines[timer.id]);
+                ASSERT_LT(now, deadlines[timer.id] + TimerWheel::kTick);
+                fired++;
+
+                // rearm once from the callback, short deadlines keep the tick walk of Advance() small
+                if (!rearmed[timer.id])
+                {
+                    rearmed[timer.id] = true;
+                    deadlines[timer.id] = random_deadline(now, 2);
+                    wheel.Schedule(timer, deadlines[timer.id]);
+                }
+            });
+
+        ASSERT_GT(wheel.NextDeadline(), now);
+        for (size_t i = 0; i < kTimers; i++)
+        {
+            if (!timers[i].armed)
+                continue;
+            ASSERT_GT(deadlines[i] + TimerWheel::kTick, now) << "timer " << i << " is overdue";
+        }
+    }
+
+    ASSERT_EQ(fired, kTimers * 2);
+    ASSERT_EQ(wheel.NextDeadline(), Clock::time_point::max());
+}
+
 TEST(DKVRCLI, CLI)
 {
     dkvr::DKVRCLI dkvr(true);